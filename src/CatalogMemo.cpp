@@ -0,0 +1,148 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <functional>
+
+#include <log4cxx/logger.h>
+#include <rbac/NamespacesCommunicator.h>
+#include <rbac/Session.h>
+
+#include "CatalogMemo.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+CatalogMemo* CatalogMemo::getInstance()
+{
+    static CatalogMemo instance;
+    return &instance;
+}
+
+bool CatalogMemo::getArrayDesc(std::shared_ptr<Query> const& query,
+                               SystemCatalog::GetArrayDescArgs const& args)
+{
+    DescKey const key(args.nsName, args.arrayName, args.versionId, args.catalogVersion);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        Queries::const_iterator it = _queries.find(query->getQueryID());
+        if (it != _queries.end())
+        {
+            std::map<DescKey, std::pair<bool, ArrayDesc> >::const_iterator desc =
+                it->second.descs.find(key);
+            if (desc != it->second.descs.end() &&
+                (desc->second.first || !args.throwIfNotFound))
+            {
+                LOG4CXX_DEBUG(logger, "secure_scan::catalog memo hit:" << args.arrayName);
+                *args.result = desc->second.second;
+                return desc->second.first;
+            }
+        }
+    }
+
+    // Outside of our lock, the catalog may throw
+    bool const found = SystemCatalog::getInstance()->getArrayDesc(args);
+    track(query);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Memo& memo = _queries[query->getQueryID()];
+        memo.descs[key] = make_pair(found, found ? *args.result : ArrayDesc());
+        if (found && args.versionId == LAST_VERSION)
+        {
+            // Also under the version found, which the coordinator pins
+            // and the later lookups of the query ask for
+            DescKey const versionKey(args.nsName,
+                                     args.arrayName,
+                                     args.result->getVersionId(),
+                                     args.catalogVersion);
+            memo.descs[versionKey] = make_pair(true, *args.result);
+        }
+    }
+    return found;
+}
+
+bool CatalogMemo::checkAccess(std::shared_ptr<Query> const& query,
+                              rbac::EntityType entityType,
+                              std::string const& entityName,
+                              rbac::Permissions permission)
+{
+    RightKey const key(entityType, entityName, permission);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        Queries::const_iterator it = _queries.find(query->getQueryID());
+        if (it != _queries.end())
+        {
+            std::map<RightKey, bool>::const_iterator right = it->second.rights.find(key);
+            if (right != it->second.rights.end())
+            {
+                return right->second;
+            }
+        }
+    }
+
+    rbac::RightsMap neededRights;
+    neededRights.upsert(entityType, entityName, permission);
+    bool granted = true;
+    try {
+        scidb::namespaces::Communicator::checkAccess(query->getSession().get(),
+                                                     &neededRights);
+    } catch (...) {
+        granted = false;
+    }
+    track(query);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queries[query->getQueryID()].rights[key] = granted;
+    }
+    return granted;
+}
+
+void CatalogMemo::track(std::shared_ptr<Query> const& query)
+{
+    QueryID const queryId = query->getQueryID();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_queries.insert(make_pair(queryId, Memo())).second)
+        {
+            return;
+        }
+    }
+
+    // Outside of our lock, pushFinalizer takes the lock of the query
+    query->pushFinalizer(std::bind(&CatalogMemo::release, this, queryId));
+}
+
+void CatalogMemo::release(QueryID queryId)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queries.erase(queryId);
+    LOG4CXX_DEBUG(logger, "secure_scan::catalog memo released for query:" << queryId);
+}
+
+} //namespace scidb
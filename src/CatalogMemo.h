@@ -0,0 +1,116 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file CatalogMemo.h
+ *
+ * @brief Catalog lookups and rights checks of a query, shared by the
+ * logical and physical phases of all its secure_scan operators.
+ *
+ * Each lookup is a round trip to the catalog database. The descriptors
+ * are memoized by namespace, name, version and catalog version, and the
+ * rights checks by entity and permission. A lookup of the last version
+ * is also memoized under the version it found, so that a later lookup
+ * of that version pinned by the coordinator does not ask again. The memo of a query is
+ * dropped when the query is finalized, so that a change of the rights
+ * of the user is seen by the next query.
+ */
+
+#ifndef CATALOG_MEMO_H_
+#define CATALOG_MEMO_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <array/Metadata.h>
+#include <query/Query.h>
+#include <rbac/Rights.h>
+#include <system/SystemCatalog.h>
+
+namespace scidb
+{
+
+class CatalogMemo
+{
+public:
+    static CatalogMemo* getInstance();
+
+    /**
+     * Look up an array descriptor, as SystemCatalog::getArrayDesc
+     * does, asking the catalog only once per query.
+     * @return false if the array does not exist and args.throwIfNotFound
+     * is false.
+     */
+    bool getArrayDesc(std::shared_ptr<Query> const& query,
+                      SystemCatalog::GetArrayDescArgs const& args);
+
+    /**
+     * Check a right of the user of the query, asking the catalog only
+     * once per query.
+     * @return true if the user has the right.
+     */
+    bool checkAccess(std::shared_ptr<Query> const& query,
+                     rbac::EntityType entityType,
+                     std::string const& entityName,
+                     rbac::Permissions permission);
+
+private:
+    CatalogMemo()
+    {}
+
+    /**
+     * Drop the memo of a query, called when it is finalized.
+     */
+    void release(QueryID queryId);
+
+    /**
+     * Register the finalizer of a query seen for the first time.
+     */
+    void track(std::shared_ptr<Query> const& query);
+
+    typedef std::tuple<std::string, std::string, VersionID, ArrayID> DescKey;
+    typedef std::tuple<int, std::string, rbac::Permissions> RightKey;
+
+    struct Memo
+    {
+        /**
+         * Whether each array was found, with its descriptor if so.
+         */
+        std::map<DescKey, std::pair<bool, ArrayDesc> > descs;
+        std::map<RightKey, bool>                       rights;
+    };
+
+    typedef std::map<QueryID, Memo> Queries;
+
+    std::mutex _mutex;
+    Queries    _queries;
+};
+
+} //namespace scidb
+
+#endif /* CATALOG_MEMO_H_ */
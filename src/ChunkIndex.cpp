@@ -0,0 +1,168 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include <log4cxx/logger.h>
+
+#include "settings.h"
+#include "ChunkIndex.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+ChunkIndex* ChunkIndex::getInstance()
+{
+    static ChunkIndex instance;
+    return &instance;
+}
+
+std::shared_ptr<ChunkIndex::Slabs const> ChunkIndex::build(ArrayDesc const& schema,
+                                                            std::shared_ptr<Array> const& array,
+                                                            size_t dimIdx)
+{
+    std::shared_ptr<Slabs> slabs = std::make_shared<Slabs>();
+    slabs->dimIdx = dimIdx;
+    slabs->nChunks = 0;
+    std::shared_ptr<ConstArrayIterator> aiter =
+        array->getConstIterator(schema.getAttributes().firstDataAttribute());
+    while (!aiter->end())
+    {
+        if (++slabs->nChunks > CHUNK_INDEX_MAX_CHUNKS)
+        {
+            LOG4CXX_DEBUG(logger, "secure_scan::too many chunks to index:" << schema.getName());
+            return std::shared_ptr<Slabs const>();
+        }
+        Coordinates const& pos = aiter->getPosition();
+        slabs->positions[pos[dimIdx]].push_back(pos);
+        ++(*aiter);
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::indexed chunks:" << slabs->nChunks
+                  << " slabs:" << slabs->positions.size());
+    return slabs;
+}
+
+std::shared_ptr<ChunkIndex::Slabs const> ChunkIndex::get(ArrayDesc const& schema,
+                                                          std::shared_ptr<Array> const& array,
+                                                          size_t dimIdx)
+{
+    Key const key(schema.getUAId(), schema.getVersionId());
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Entries::iterator it = _entries.find(key);
+        if (it != _entries.end() && (!it->second.slabs || it->second.slabs->dimIdx == dimIdx))
+        {
+            _uses.splice(_uses.begin(), _uses, it->second.use);
+            return it->second.slabs;
+        }
+    }
+
+    // Outside of our lock, the walk may be long
+    std::shared_ptr<Slabs const> slabs = build(schema, array, dimIdx);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entries::iterator it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        // Built by another query meanwhile, or along another dimension
+        erase(it);
+    }
+
+    // Drop the least recently used indexes until the new one fits in
+    // both budgets
+    size_t const nChunks = slabs ? slabs->nChunks : 0;
+    while (!_entries.empty() &&
+           (_entries.size() >= CHUNK_INDEX_SIZE || _nChunks + nChunks > CHUNK_INDEX_MAX_CHUNKS))
+    {
+        Entries::iterator victim = _entries.find(_uses.back());
+        SCIDB_ASSERT(victim != _entries.end());
+        erase(victim);
+    }
+    _uses.push_front(key);
+    it = _entries.insert(make_pair(key, Entry())).first;
+    it->second.slabs = slabs;
+    it->second.use = _uses.begin();
+    _nChunks += nChunks;
+    return slabs;
+}
+
+void ChunkIndex::erase(Entries::iterator it)
+{
+    if (it->second.slabs)
+    {
+        _nChunks -= it->second.slabs->nChunks;
+    }
+    _uses.erase(it->second.use);
+    _entries.erase(it);
+}
+
+std::shared_ptr<std::vector<Coordinates> const> ChunkIndex::listChunks(ArrayDesc const& schema,
+                                                                       std::shared_ptr<Array> const& array,
+                                                                       ChunkPlan const& plan,
+                                                                       std::shared_ptr<Query> const& query)
+{
+    std::shared_ptr<std::vector<Coordinates> > chunks;
+    if (CHUNK_INDEX_SIZE == 0 ||
+        plan.getDimensions().empty() ||
+        query->isDistributionDegradedForRead(schema))
+    {
+        return chunks;
+    }
+    ChunkPlan::Dimension const& dimension = plan.getDimensions().front();
+    std::shared_ptr<Slabs const> slabs = get(schema, array, dimension.getDimIdx());
+    if (!slabs)
+    {
+        return chunks;
+    }
+
+    // Only the permitted slabs are looked up, and their chunks checked
+    // against the other permission dimensions
+    chunks = std::make_shared<std::vector<Coordinates> >();
+    std::vector<ChunkPlan::Slab> const& planSlabs = dimension.getSlabs();
+    std::vector<size_t> hints;
+    for (size_t s = 0; s < planSlabs.size(); s++)
+    {
+        std::map<Coordinate, std::vector<Coordinates> >::const_iterator it =
+            slabs->positions.lower_bound(planSlabs[s].firstStart);
+        for (; it != slabs->positions.end() && it->first <= planSlabs[s].lastStart; ++it)
+        {
+            for (size_t i = 0; i < it->second.size(); i++)
+            {
+                if (plan.getKind(it->second[i], hints) != ChunkPlan::SKIP)
+                {
+                    chunks->push_back(it->second[i]);
+                }
+            }
+        }
+    }
+    std::sort(chunks->begin(), chunks->end());
+    LOG4CXX_DEBUG(logger, "secure_scan::indexed permitted chunks:" << chunks->size());
+    return chunks;
+}
+
+} //namespace scidb
@@ -0,0 +1,145 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file ChunkIndex.h
+ *
+ * @brief Per-instance index of the chunks of the data arrays stored on
+ * the instance, grouped by chunk coordinate along the permission
+ * dimension.
+ *
+ * A secure_scan of a user who may read a small part of a large or
+ * sparse array would otherwise walk every local chunk of the array, or
+ * probe the storage for every permitted chunk position. With the index
+ * it visits exactly the permitted chunks that exist.
+ *
+ * The index of an array version is built the first time it is scanned,
+ * by walking the positions of its local chunks without reading them.
+ * Since a version of a persistent array never changes, the index needs
+ * no maintenance: a new version gets its own index, and the least
+ * recently used indexes are dropped when the number of indexes or the
+ * number of chunks indexed over all of them exceeds its budget. The
+ * indexes are kept in a list in order of use next to the map, so that
+ * an eviction takes constant time.
+ *
+ * The chunks an instance serves change when the distribution of the
+ * array is degraded for reading, so the index is neither built nor
+ * used by those queries.
+ */
+
+#ifndef CHUNK_INDEX_H_
+#define CHUNK_INDEX_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <array/Array.h>
+#include <array/Metadata.h>
+#include <query/Query.h>
+
+#include "ChunkPlan.h"
+
+namespace scidb
+{
+
+class ChunkIndex
+{
+public:
+    static ChunkIndex* getInstance();
+
+    /**
+     * List the local chunks of an array that the plan does not skip,
+     * building the index of the array if needed.
+     * @param schema the schema of the array, with its UAId and version.
+     * @param array the stored array.
+     * @param plan the plan, whose first dimension is the one the index
+     *             is grouped by.
+     * @return the positions in row-major order, null if the array is
+     * not indexed because it has more local chunks than the whole
+     * CHUNK_INDEX_MAX_CHUNKS budget, its distribution is degraded for
+     * reading, or indexing is disabled.
+     */
+    std::shared_ptr<std::vector<Coordinates> const> listChunks(ArrayDesc const& schema,
+                                                               std::shared_ptr<Array> const& array,
+                                                               ChunkPlan const& plan,
+                                                               std::shared_ptr<Query> const& query);
+
+private:
+    ChunkIndex()
+        : _nChunks(0)
+    {}
+
+    /**
+     * The positions of the local chunks, by chunk coordinate along the
+     * indexed dimension.
+     */
+    struct Slabs
+    {
+        size_t                                       dimIdx;
+        size_t                                       nChunks;
+        std::map<Coordinate, std::vector<Coordinates> > positions;
+    };
+
+    typedef std::pair<ArrayUAID, VersionID> Key;
+    typedef std::list<Key> UseList;
+
+    struct Entry
+    {
+        std::shared_ptr<Slabs const> slabs;
+        UseList::iterator            use;
+    };
+
+    typedef std::map<Key, Entry> Entries;
+
+    /**
+     * Walk the positions of the local chunks of an array.
+     * @return null if there are more than CHUNK_INDEX_MAX_CHUNKS.
+     */
+    static std::shared_ptr<Slabs const> build(ArrayDesc const& schema,
+                                              std::shared_ptr<Array> const& array,
+                                              size_t dimIdx);
+
+    std::shared_ptr<Slabs const> get(ArrayDesc const& schema,
+                                     std::shared_ptr<Array> const& array,
+                                     size_t dimIdx);
+
+    /**
+     * Drop an index and its position in the use list.
+     * @pre _mutex is held.
+     */
+    void erase(Entries::iterator it);
+
+    std::mutex _mutex;
+    Entries    _entries;
+    UseList    _uses;    // most recently used first
+    size_t     _nChunks; // over all the indexes
+};
+
+} //namespace scidb
+
+#endif /* CHUNK_INDEX_H_ */
@@ -0,0 +1,382 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include <log4cxx/logger.h>
+
+#include "ChunkPlan.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+namespace
+{
+    bool slabBefore(ChunkPlan::Slab const& slab, Coordinate chunkStart)
+    {
+        return slab.lastStart < chunkStart;
+    }
+
+    bool intervalBefore(PermissionIntervals::Interval const& interval, Coordinate coord)
+    {
+        return interval.second < coord;
+    }
+
+    /**
+     * @return the chunk coordinate of the chunk holding coord.
+     */
+    Coordinate chunkStartOf(Coordinate coord, Coordinate start, int64_t interval)
+    {
+        return start + (coord - start) / interval * interval;
+    }
+}
+
+ChunkPlan::Dimension::Dimension(PermissionIntervals const& intervals,
+                                Dimensions const& dims,
+                                size_t dimIdx)
+    : _dimIdx(dimIdx)
+    , _intervals(intervals)
+{
+    SCIDB_ASSERT(dimIdx < dims.size());
+    DimensionDesc const& dim = dims[dimIdx];
+    Coordinate const start    = dim.getStartMin();
+    Coordinate const endMax   = dim.getEndMax();
+    int64_t const    interval = dim.getChunkInterval();
+    int64_t const    overlap  = dim.getChunkOverlap();
+    SCIDB_ASSERT(interval > 0);
+
+    // Only the chunks within the bounds of the data are kept, when known
+    Coordinate dataLow = start;
+    Coordinate dataHigh = endMax;
+    if (dim.getCurrStart() <= dim.getCurrEnd())
+    {
+        dataLow = std::max(dataLow, dim.getCurrStart());
+        dataHigh = std::min(dataHigh, dim.getCurrEnd());
+    }
+
+    vector<PermissionIntervals::Interval> const& items = _intervals.intervals();
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        // Permissions outside of the data array are ignored
+        Coordinate const low  = std::max(items[i].first, start);
+        Coordinate const high = std::min(items[i].second, endMax);
+        if (std::max(low, dataLow) > std::min(high, dataHigh))
+        {
+            continue;
+        }
+        Coordinate const first = chunkStartOf(std::max(low, dataLow), start, interval);
+        Coordinate const last = chunkStartOf(std::min(high, dataHigh), start, interval);
+
+        // A chunk is passed through if the interval covers it, overlaps
+        // included, which holds for a range of consecutive chunks
+        Coordinate passFirst = first;
+        if (low > start)
+        {
+            passFirst = chunkStartOf(low + overlap + interval - 1, start, interval);
+        }
+        Coordinate passLast = last;
+        if (high < endMax)
+        {
+            passLast = high - overlap - interval + 1 < start
+                ? first - interval
+                : chunkStartOf(high - overlap - interval + 1, start, interval);
+        }
+        passFirst = std::max(passFirst, first);
+        passLast = std::min(passLast, last);
+
+        if (passFirst > passLast)
+        {
+            addRun(first, last, MASKED, interval);
+        }
+        else
+        {
+            addRun(first, passFirst - interval, MASKED, interval);
+            addRun(passFirst, passLast, PASS_THROUGH, interval);
+            addRun(passLast + interval, last, MASKED, interval);
+        }
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::ChunkPlan dim:" << dimIdx << " slab runs:" << _slabs.size());
+
+    if (PermissionBitmap::isFragmented(_intervals.size(), _intervals.cardinality()))
+    {
+        _bitmap = make_shared<PermissionBitmap>(_intervals);
+        _intervals = PermissionIntervals();
+        LOG4CXX_DEBUG(logger, "secure_scan::ChunkPlan bitmap:" << _bitmap->getMemorySize());
+    }
+}
+
+void ChunkPlan::Dimension::addRun(Coordinate firstStart,
+                                  Coordinate lastStart,
+                                  Kind kind,
+                                  int64_t interval)
+{
+    if (firstStart > lastStart)
+    {
+        return;
+    }
+    if (!_slabs.empty() && _slabs.back().lastStart >= firstStart)
+    {
+        // The first chunk was touched by the previous interval, the gap
+        // between the two is in this chunk
+        SCIDB_ASSERT(_slabs.back().lastStart == firstStart);
+        if (_slabs.back().kind != MASKED)
+        {
+            _slabs.back().lastStart -= interval;
+            if (_slabs.back().lastStart < _slabs.back().firstStart)
+            {
+                _slabs.pop_back();
+            }
+            addRun(firstStart, firstStart, MASKED, interval);
+        }
+        firstStart += interval;
+        if (firstStart > lastStart)
+        {
+            return;
+        }
+    }
+    if (!_slabs.empty() &&
+        _slabs.back().kind == kind &&
+        _slabs.back().lastStart + interval == firstStart)
+    {
+        _slabs.back().lastStart = lastStart;
+        return;
+    }
+    Slab slab = { firstStart, lastStart, kind };
+    _slabs.push_back(slab);
+}
+
+ChunkPlan::Kind ChunkPlan::Dimension::getKind(Coordinate chunkStart, size_t& hint) const
+{
+    // Chunks are usually visited in order, try the hint and the next
+    // slab first
+    for (size_t i = hint; i < _slabs.size() && i <= hint + 1; i++)
+    {
+        if (_slabs[i].firstStart <= chunkStart && chunkStart <= _slabs[i].lastStart)
+        {
+            hint = i;
+            return _slabs[i].kind;
+        }
+    }
+
+    vector<Slab>::const_iterator it =
+        std::lower_bound(_slabs.begin(), _slabs.end(), chunkStart, slabBefore);
+    if (it == _slabs.end() || it->firstStart > chunkStart)
+    {
+        return SKIP;
+    }
+    hint = it - _slabs.begin();
+    return it->kind;
+}
+
+void ChunkPlan::Dimension::buildMask(Coordinate low, Coordinate high, vector<bool>& mask) const
+{
+    if (_bitmap)
+    {
+        _bitmap->buildMask(low, high, mask);
+        return;
+    }
+
+    SCIDB_ASSERT(low <= high);
+    mask.assign(high - low + 1, false);
+
+    vector<PermissionIntervals::Interval> const& items = _intervals.intervals();
+    vector<PermissionIntervals::Interval>::const_iterator it =
+        std::lower_bound(items.begin(), items.end(), low, intervalBefore);
+    for (; it != items.end() && it->first <= high; ++it)
+    {
+        Coordinate const from = std::max(it->first, low);
+        Coordinate const to = std::min(it->second, high);
+        std::fill(mask.begin() + (from - low), mask.begin() + (to - low + 1), true);
+    }
+}
+
+uint64_t ChunkPlan::Dimension::countPermitted(Coordinate low, Coordinate high) const
+{
+    vector<bool> mask;
+    buildMask(low, high, mask);
+    return std::count(mask.begin(), mask.end(), true);
+}
+
+void ChunkPlan::addDimension(PermissionIntervals const& intervals,
+                             Dimensions const& dims,
+                             size_t dimIdx)
+{
+    _dimensions.push_back(Dimension(intervals, dims, dimIdx));
+}
+
+ChunkPlan::Kind ChunkPlan::getKind(Coordinates const& chunkPos, vector<size_t>& hints) const
+{
+    hints.resize(_dimensions.size(), 0);
+
+    Kind kind = PASS_THROUGH;
+    for (size_t i = 0; i < _dimensions.size(); i++)
+    {
+        Dimension const& dimension = _dimensions[i];
+        Kind const dimKind = dimension.getKind(chunkPos[dimension.getDimIdx()], hints[i]);
+        if (dimKind == SKIP)
+        {
+            return SKIP;
+        }
+        if (dimKind == MASKED)
+        {
+            kind = MASKED;
+        }
+    }
+    return kind;
+}
+
+void ChunkPlan::Mask::reset(ChunkPlan const& plan,
+                            Coordinates const& chunkPos,
+                            Coordinates const& firstPos,
+                            Coordinates const& lastPos)
+{
+    _masks.clear();
+    vector<Dimension> const& dimensions = plan.getDimensions();
+    for (size_t i = 0; i < dimensions.size(); i++)
+    {
+        Dimension const& dimension = dimensions[i];
+        size_t const dimIdx = dimension.getDimIdx();
+        size_t hint = 0;
+        if (dimension.getKind(chunkPos[dimIdx], hint) == PASS_THROUGH)
+        {
+            continue;
+        }
+
+        _masks.push_back(DimensionMask());
+        DimensionMask& mask = _masks.back();
+        mask.dimIdx = dimIdx;
+        mask.bitmap = dimension.getBitmap();
+        mask.origin = firstPos[dimIdx];
+        if (!mask.bitmap)
+        {
+            dimension.buildMask(firstPos[dimIdx], lastPos[dimIdx], mask.mask);
+        }
+    }
+}
+
+bool ChunkPlan::listChunks(Dimensions const& dims,
+                           Coordinates const& low,
+                           Coordinates const& high,
+                           size_t maxChunks,
+                           vector<Coordinates>& chunks) const
+{
+    chunks.clear();
+    size_t const nDims = dims.size();
+
+    // The chunk starts along each dimension: the slabs of the
+    // permission dimensions, every chunk within the bounds otherwise
+    vector<vector<Coordinate> > starts(nDims);
+    uint64_t count = 1;
+    for (size_t i = 0; i < nDims; i++)
+    {
+        if (low[i] > high[i])
+        {
+            return true;
+        }
+        Coordinate const start = dims[i].getStartMin();
+        int64_t const interval = dims[i].getChunkInterval();
+        Coordinate const first = start + (low[i] - start) / interval * interval;
+
+        vector<Dimension>::const_iterator dimension = _dimensions.begin();
+        while (dimension != _dimensions.end() && dimension->getDimIdx() != i)
+        {
+            ++dimension;
+        }
+        if (dimension != _dimensions.end())
+        {
+            // The runs are expanded within the bounds only, and no
+            // further than maxChunks
+            vector<Slab> const& slabs = dimension->getSlabs();
+            for (size_t s = 0; s < slabs.size(); s++)
+            {
+                Coordinate const from = std::max(slabs[s].firstStart, first);
+                Coordinate const to = std::min(slabs[s].lastStart, high[i]);
+                if (from > to)
+                {
+                    continue;
+                }
+                if (starts[i].size() + uint64_t((to - from) / interval) >= maxChunks)
+                {
+                    return false;
+                }
+                for (Coordinate c = from; c <= to; c += interval)
+                {
+                    starts[i].push_back(c);
+                }
+            }
+        }
+        else
+        {
+            if (uint64_t((high[i] - first) / interval) >= maxChunks)
+            {
+                return false;
+            }
+            for (Coordinate c = first; c <= high[i]; c += interval)
+            {
+                starts[i].push_back(c);
+            }
+        }
+
+        count *= starts[i].size();
+        if (count == 0)
+        {
+            return true;
+        }
+        if (count > maxChunks)
+        {
+            return false;
+        }
+    }
+
+    // Odometer over the chunk starts, the last dimension fastest
+    vector<size_t> idx(nDims, 0);
+    Coordinates pos(nDims);
+    chunks.reserve(count);
+    while (true)
+    {
+        for (size_t i = 0; i < nDims; i++)
+        {
+            pos[i] = starts[i][idx[i]];
+        }
+        chunks.push_back(pos);
+
+        size_t i = nDims;
+        while (i > 0 && ++idx[i - 1] == starts[i - 1].size())
+        {
+            idx[i - 1] = 0;
+            i--;
+        }
+        if (i == 0)
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+} //namespace scidb
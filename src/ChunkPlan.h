@@ -0,0 +1,276 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file ChunkPlan.h
+ *
+ * @brief The permitted intervals mapped onto the chunks of the data
+ * array.
+ *
+ * Along each permission dimension, every chunk in the same slab, i.e.
+ * with the same chunk coordinate along that dimension, gets the same
+ * treatment:
+ *   - SKIP: no permitted cell, the chunk is not returned.
+ *   - PASS_THROUGH: every cell, overlaps included, is permitted, the
+ *     stored chunk is returned as-is.
+ *   - MASKED: some cells are permitted, the chunk is filtered with a
+ *     mask along the permission dimension.
+ *
+ * Only the slabs that are not skipped are kept, as runs of consecutive
+ * slabs with the same treatment, within the bounds of the data in the
+ * array. A permitted interval gives at most three runs, masked at its
+ * ends and passed through in between, so the plan grows with the number
+ * of intervals rather than with the number of chunks they span.
+ *
+ * When the permissions are fragmented the intervals are replaced by a
+ * PermissionBitmap once the slabs are built, and masked chunks test
+ * their cells against the bitmap instead of building a mask.
+ *
+ * With several permission dimensions, a chunk is skipped if it is
+ * skipped along any of them, and passed through only if it is passed
+ * through along all of them, so chunks are pruned on all permission
+ * dimensions in one pass.
+ */
+
+#ifndef CHUNK_PLAN_H_
+#define CHUNK_PLAN_H_
+
+#include <memory>
+#include <vector>
+
+#include <array/Metadata.h>
+
+#include "PermissionBitmap.h"
+#include "PermissionIntervals.h"
+
+namespace scidb
+{
+
+class ChunkPlan
+{
+public:
+    enum Kind
+    {
+        SKIP,
+        PASS_THROUGH,
+        MASKED
+    };
+
+    /**
+     * A run of consecutive slabs with the same kind.
+     */
+    struct Slab
+    {
+        Coordinate firstStart;  // chunk coordinate of the first slab
+        Coordinate lastStart;   // chunk coordinate of the last slab
+        Kind       kind;
+    };
+
+    /**
+     * The plan along one permission dimension.
+     */
+    class Dimension
+    {
+    public:
+        /**
+         * @param intervals the permitted intervals.
+         * @param dims the data array dimensions.
+         * @param dimIdx the index of the permission dimension in dims.
+         */
+        Dimension(PermissionIntervals const& intervals,
+                  Dimensions const& dims,
+                  size_t dimIdx);
+
+        /**
+         * @param chunkStart the chunk coordinate along the dimension.
+         * @param hint the slab found by the previous call, for faster
+         *             lookups when chunks are visited in order.
+         */
+        Kind getKind(Coordinate chunkStart, size_t& hint) const;
+
+        /**
+         * Build the mask of the permitted coordinates in [low, high]
+         * along the dimension: mask[i] is set if low + i is permitted.
+         */
+        void buildMask(Coordinate low, Coordinate high, std::vector<bool>& mask) const;
+
+        /**
+         * @return the number of permitted coordinates in [low, high].
+         */
+        uint64_t countPermitted(Coordinate low, Coordinate high) const;
+
+        size_t getDimIdx() const
+        {
+            return _dimIdx;
+        }
+
+        /**
+         * @return the permitted intervals, empty if the plan uses a bitmap.
+         */
+        PermissionIntervals const& getIntervals() const
+        {
+            return _intervals;
+        }
+
+        /**
+         * @return the permitted bitmap, null if the plan uses intervals.
+         */
+        PermissionBitmap const* getBitmap() const
+        {
+            return _bitmap.get();
+        }
+
+        std::vector<Slab> const& getSlabs() const
+        {
+            return _slabs;
+        }
+
+    private:
+        /**
+         * Append a run of slabs, after the runs of the previous
+         * intervals.
+         */
+        void addRun(Coordinate firstStart, Coordinate lastStart, Kind kind, int64_t interval);
+
+        size_t              _dimIdx;
+        PermissionIntervals _intervals;
+        std::shared_ptr<PermissionBitmap> _bitmap;
+        std::vector<Slab>   _slabs;
+    };
+
+    /**
+     * The permitted cells of one chunk that is not skipped.
+     */
+    class Mask
+    {
+    public:
+        /**
+         * Build the mask of a chunk along every permission dimension
+         * along which it is not passed through.
+         * @param chunkPos the position of the chunk.
+         * @param firstPos, lastPos the bounds of the chunk, overlaps
+         *                          included.
+         */
+        void reset(ChunkPlan const& plan,
+                   Coordinates const& chunkPos,
+                   Coordinates const& firstPos,
+                   Coordinates const& lastPos);
+
+        bool isPermitted(Coordinates const& pos) const
+        {
+            for (size_t i = 0; i < _masks.size(); i++)
+            {
+                if (!_masks[i].contains(pos[_masks[i].dimIdx]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * The permitted coordinates of the chunk along one permission
+         * dimension. Dimensions along which the chunk is passed through
+         * have no mask.
+         */
+        struct DimensionMask
+        {
+            size_t                  dimIdx;
+            PermissionBitmap const* bitmap;
+            Coordinate              origin;
+            std::vector<bool>       mask;
+
+            bool contains(Coordinate coord) const
+            {
+                if (bitmap)
+                {
+                    return bitmap->contains(coord);
+                }
+                Coordinate const offset = coord - origin;
+                return offset >= 0 &&
+                    static_cast<size_t>(offset) < mask.size() &&
+                    mask[offset];
+            }
+        };
+
+        /**
+         * @return the number of dimensions along which the chunk is
+         * masked.
+         */
+        size_t size() const
+        {
+            return _masks.size();
+        }
+
+        DimensionMask const& operator[](size_t i) const
+        {
+            return _masks[i];
+        }
+
+    private:
+        std::vector<DimensionMask> _masks;
+    };
+
+    /**
+     * Restrict the plan along one more permission dimension.
+     */
+    void addDimension(PermissionIntervals const& intervals,
+                      Dimensions const& dims,
+                      size_t dimIdx);
+
+    /**
+     * @param chunkPos the position of a chunk of the data array.
+     * @param hints the slabs found by the previous call, one per
+     *              permission dimension.
+     */
+    Kind getKind(Coordinates const& chunkPos, std::vector<size_t>& hints) const;
+
+    std::vector<Dimension> const& getDimensions() const
+    {
+        return _dimensions;
+    }
+
+    /**
+     * List the positions of the chunks that are not skipped, in
+     * row-major order.
+     * @param dims the data array dimensions.
+     * @param low, high the bounds of the data array.
+     * @param maxChunks the largest list to build.
+     * @param[out] chunks the positions.
+     * @return false if there would be more than maxChunks positions.
+     */
+    bool listChunks(Dimensions const& dims,
+                    Coordinates const& low,
+                    Coordinates const& high,
+                    size_t maxChunks,
+                    std::vector<Coordinates>& chunks) const;
+
+private:
+    std::vector<Dimension> _dimensions;
+};
+
+} //namespace scidb
+
+#endif /* CHUNK_PLAN_H_ */
@@ -0,0 +1,220 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include <log4cxx/logger.h>
+
+#include "settings.h"
+#include "ChunkPrefetcher.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+ChunkPrefetcher* ChunkPrefetcher::getInstance()
+{
+    static ChunkPrefetcher instance;
+    return &instance;
+}
+
+ChunkPrefetcher::~ChunkPrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_one();
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+size_t ChunkPrefetcher::addStream(std::shared_ptr<Array> const& input,
+                                  std::vector<AttributeDesc> const& attrs,
+                                  std::shared_ptr<std::vector<Coordinates> const> const& chunks)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t const streamId = _nextId++;
+    Stream& stream = _streams[streamId];
+    stream.input = input;
+    stream.attrs = attrs;
+    stream.chunks = chunks;
+    stream.failed = false;
+    stream.consumed = 0;
+    stream.next = 0;
+    if (!_thread.joinable())
+    {
+        _thread = std::thread(&ChunkPrefetcher::run, this);
+    }
+    return streamId;
+}
+
+void ChunkPrefetcher::removeStream(size_t streamId)
+{
+    Stream removed;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _read.wait(lock, [this, streamId]() {
+            return _readingId != streamId;
+        });
+        Streams::iterator it = _streams.find(streamId);
+        if (it == _streams.end())
+        {
+            return;
+        }
+        release(it->second, it->second.chunks->size());
+        // The iterators and the input are released out of the lock
+        std::swap(removed, it->second);
+        _streams.erase(it);
+    }
+    _wake.notify_one();
+}
+
+void ChunkPrefetcher::advance(size_t streamId, size_t chunkIdx)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Streams::iterator it = _streams.find(streamId);
+        if (_stop || it == _streams.end())
+        {
+            return;
+        }
+        Stream& stream = it->second;
+        stream.consumed = std::max(stream.consumed, chunkIdx);
+        stream.next = std::max(stream.next, stream.consumed + 1);
+        release(stream, stream.consumed);
+    }
+    _wake.notify_one();
+}
+
+void ChunkPrefetcher::release(Stream& stream, size_t upTo)
+{
+    while (!stream.ahead.empty() && stream.ahead.front().first <= upTo)
+    {
+        _aheadChunks--;
+        _aheadBytes -= stream.ahead.front().second;
+        stream.ahead.pop_front();
+    }
+}
+
+ChunkPrefetcher::Streams::iterator ChunkPrefetcher::pickStream()
+{
+    Streams::iterator it = _streams.upper_bound(_lastId);
+    for (size_t n = 0; n < _streams.size(); n++, ++it)
+    {
+        if (it == _streams.end())
+        {
+            it = _streams.begin();
+        }
+        if (!it->second.failed && it->second.next < it->second.chunks->size())
+        {
+            return it;
+        }
+    }
+    return _streams.end();
+}
+
+void ChunkPrefetcher::run()
+{
+    size_t nRead = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        Streams::iterator it = _streams.end();
+        _wake.wait(lock, [this, &it]() {
+            if (_stop)
+            {
+                return true;
+            }
+            if (_aheadChunks >= PREFETCH_CHUNKS || _aheadBytes >= PREFETCH_MAX_BYTES)
+            {
+                return false;
+            }
+            it = pickStream();
+            return it != _streams.end();
+        });
+        if (_stop)
+        {
+            break;
+        }
+
+        // The stream stays registered while it is being read
+        size_t const streamId = it->first;
+        Stream& stream = it->second;
+        size_t const chunkIdx = stream.next++;
+        _lastId = streamId;
+        _readingId = streamId;
+        lock.unlock();
+
+        size_t bytes = 0;
+        bool failed = false;
+        try
+        {
+            if (stream.aiters.empty())
+            {
+                for (auto const& attr : stream.attrs)
+                {
+                    stream.aiters.push_back(stream.input->getConstIterator(attr));
+                }
+            }
+            Coordinates const& chunkPos = (*stream.chunks)[chunkIdx];
+            for (size_t i = 0; i < stream.aiters.size(); i++)
+            {
+                if (stream.aiters[i]->setPosition(chunkPos))
+                {
+                    ConstChunk const& chunk = stream.aiters[i]->getChunk();
+                    chunk.pin();
+                    bytes += chunk.getSize();
+                    chunk.unPin();
+                }
+            }
+            nRead++;
+        }
+        catch (std::exception const& e)
+        {
+            // The iterators of the stream read the chunks themselves
+            LOG4CXX_DEBUG(logger, "secure_scan::prefetch stopped:" << e.what());
+            failed = true;
+        }
+
+        lock.lock();
+        _readingId = 0;
+        stream.failed = failed;
+        if (!failed && chunkIdx > stream.consumed)
+        {
+            stream.ahead.emplace_back(chunkIdx, bytes);
+            _aheadChunks++;
+            _aheadBytes += bytes;
+        }
+        _read.notify_all();
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::prefetched chunks:" << nRead);
+}
+
+} //namespace scidb
@@ -0,0 +1,156 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+/**
+ * @file ChunkPrefetcher.h
+ *
+ * @brief Read-ahead of the chunks the secure_scan queries are about to
+ * return.
+ *
+ * When the positions of the chunks to visit are listed up front, the
+ * scan registers them as a stream, and a single background thread per
+ * instance reads the chunks of every attribute at the next listed
+ * positions of the streams, ahead of their array iterators, so that the
+ * storage reads and decompression of a chunk overlap with the
+ * processing of the previous ones downstream. Only the attributes the
+ * scan returns are read. The read chunks are only pinned and released,
+ * leaving them in the buffer cache for the iterators.
+ *
+ * The thread visits the streams in turn, one position at a time. The
+ * positions read ahead of their iterators by all the streams of the
+ * instance are at most PREFETCH_CHUNKS, of at most PREFETCH_MAX_BYTES.
+ * These limits only pace the reads: no chunk stays pinned, so the
+ * memory they take is that of the buffer cache, which may evict a chunk
+ * read ahead before its iterator reaches it.
+ */
+
+#ifndef CHUNK_PREFETCHER_H_
+#define CHUNK_PREFETCHER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <array/Array.h>
+
+namespace scidb
+{
+
+class ChunkPrefetcher
+{
+public:
+    static ChunkPrefetcher* getInstance();
+
+    /**
+     * Register the positions a scan is about to visit, starting the
+     * thread on the first call.
+     * @param attrs the attributes of the input whose chunks are read.
+     * @param chunks the positions of the chunks to read, in the order
+     *               the iterators visit them.
+     * @return the ID of the stream, never 0.
+     */
+    size_t addStream(std::shared_ptr<Array> const& input,
+                     std::vector<AttributeDesc> const& attrs,
+                     std::shared_ptr<std::vector<Coordinates> const> const& chunks);
+
+    /**
+     * Unregister a stream, waiting for the thread if it is reading it.
+     */
+    void removeStream(size_t streamId);
+
+    /**
+     * Record that an iterator of a stream reached a listed position.
+     * @param chunkIdx the index of the position in the list.
+     */
+    void advance(size_t streamId, size_t chunkIdx);
+
+private:
+    ChunkPrefetcher()
+        : _stop(false)
+        , _nextId(1)
+        , _lastId(0)
+        , _readingId(0)
+        , _aheadChunks(0)
+        , _aheadBytes(0)
+    {}
+
+    /**
+     * Stop the thread and wait for it.
+     */
+    ~ChunkPrefetcher();
+
+    struct Stream
+    {
+        std::shared_ptr<Array>                          input;
+        std::vector<AttributeDesc>                      attrs;
+        std::shared_ptr<std::vector<Coordinates> const> chunks;
+        std::vector<std::shared_ptr<ConstArrayIterator> > aiters; // of the thread
+
+        bool   failed;
+        size_t consumed;  // furthest position reached by an iterator
+        size_t next;      // next position to read
+
+        // Positions read ahead of the iterators, with their size in bytes
+        std::deque<std::pair<size_t, size_t> > ahead;
+    };
+
+    typedef std::map<size_t, Stream> Streams;
+
+    /**
+     * @return the stream to read next, after the last one read, or
+     * _streams.end() if none has positions left.
+     * @pre _mutex is held.
+     */
+    Streams::iterator pickStream();
+
+    /**
+     * Forget the positions of a stream read ahead of its iterators.
+     * @pre _mutex is held.
+     */
+    void release(Stream& stream, size_t upTo);
+
+    void run();
+
+    std::mutex              _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _read;   // a position was read
+    bool                    _stop;
+    Streams                 _streams;
+    size_t                  _nextId;
+    size_t                  _lastId;     // stream read last
+    size_t                  _readingId;  // stream being read, 0 if none
+    size_t                  _aheadChunks;
+    size_t                  _aheadBytes;
+
+    std::thread _thread;
+};
+
+} //namespace scidb
+
+#endif /* CHUNK_PREFETCHER_H_ */
@@ -0,0 +1,279 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+#include <sstream>
+
+#include <log4cxx/logger.h>
+#include <array/MemArray.h>
+
+#include "settings.h"
+#include "ExplainArray.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+namespace
+{
+    enum ExplainAttribute
+    {
+        EXPLAIN_KIND,
+        EXPLAIN_DIMENSION,
+        EXPLAIN_LOW,
+        EXPLAIN_HIGH,
+        EXPLAIN_COUNT,
+        EXPLAIN_CHUNK,
+        EXPLAIN_TREATMENT,
+        EXPLAIN_ATTRIBUTES
+    };
+
+    /**
+     * Writes the entries of the local instance, in order along the
+     * entry dimension.
+     */
+    class ExplainWriter
+    {
+    public:
+        ExplainWriter(std::shared_ptr<Array> const& array, std::shared_ptr<Query> const& query)
+            : _array(array),
+              _query(query),
+              _pos(2),
+              _citers(EXPLAIN_ATTRIBUTES),
+              _values(EXPLAIN_ATTRIBUTES)
+        {
+            for (auto const& attr : array->getArrayDesc().getAttributes(true))
+            {
+                _aiters.push_back(array->getIterator(attr));
+            }
+            SCIDB_ASSERT(_aiters.size() == EXPLAIN_ATTRIBUTES);
+            _pos[0] = query->getInstanceID();
+            _pos[1] = 0;
+            clear();
+        }
+
+        void setString(ExplainAttribute attr, std::string const& value)
+        {
+            _values[attr].setString(value);
+        }
+
+        void setInt64(ExplainAttribute attr, int64_t value)
+        {
+            _values[attr].setInt64(value);
+        }
+
+        void setUint64(ExplainAttribute attr, uint64_t value)
+        {
+            _values[attr].setUint64(value);
+        }
+
+        /**
+         * Write the current entry and clear the values.
+         */
+        void write()
+        {
+            Coordinates chunkPos = _pos;
+            _array->getArrayDesc().getChunkPositionFor(chunkPos);
+            if (chunkPos != _chunkPos)
+            {
+                flush();
+                _chunkPos = chunkPos;
+                for (size_t i = 0; i < _aiters.size(); i++)
+                {
+                    Chunk& chunk = _aiters[i]->newChunk(_chunkPos);
+                    _citers[i] = chunk.getIterator(_query,
+                                                   i == 0
+                                                   ? ChunkIterator::SEQUENTIAL_WRITE
+                                                   : ChunkIterator::SEQUENTIAL_WRITE |
+                                                     ChunkIterator::NO_EMPTY_CHECK);
+                }
+            }
+            for (size_t i = 0; i < _citers.size(); i++)
+            {
+                _citers[i]->setPosition(_pos);
+                _citers[i]->writeItem(_values[i]);
+            }
+            _pos[1]++;
+            clear();
+        }
+
+        void flush()
+        {
+            for (size_t i = 0; i < _citers.size(); i++)
+            {
+                if (_citers[i])
+                {
+                    _citers[i]->flush();
+                    _citers[i].reset();
+                }
+            }
+        }
+
+    private:
+        void clear()
+        {
+            for (size_t i = 0; i < _values.size(); i++)
+            {
+                _values[i].setNull();
+            }
+        }
+
+        std::shared_ptr<Array>                      _array;
+        std::shared_ptr<Query>                      _query;
+        Coordinates                                 _pos;
+        Coordinates                                 _chunkPos;
+        std::vector<std::shared_ptr<ArrayIterator> > _aiters;
+        std::vector<std::shared_ptr<ChunkIterator> > _citers;
+        std::vector<Value>                          _values;
+    };
+
+    std::string formatPosition(Coordinates const& pos)
+    {
+        std::ostringstream out;
+        out << '{';
+        for (size_t i = 0; i < pos.size(); i++)
+        {
+            out << (i ? "," : "") << pos[i];
+        }
+        out << '}';
+        return out.str();
+    }
+}
+
+ArrayDesc makeExplainSchema(std::shared_ptr<Query> const& query)
+{
+    Attributes attributes;
+    attributes.push_back(AttributeDesc("kind", TID_STRING, 0, CompressorType::NONE));
+    attributes.push_back(AttributeDesc("dimension", TID_STRING, AttributeDesc::IS_NULLABLE, CompressorType::NONE));
+    attributes.push_back(AttributeDesc("low", TID_INT64, AttributeDesc::IS_NULLABLE, CompressorType::NONE));
+    attributes.push_back(AttributeDesc("high", TID_INT64, AttributeDesc::IS_NULLABLE, CompressorType::NONE));
+    attributes.push_back(AttributeDesc("count", TID_UINT64, AttributeDesc::IS_NULLABLE, CompressorType::NONE));
+    attributes.push_back(AttributeDesc("chunk", TID_STRING, AttributeDesc::IS_NULLABLE, CompressorType::NONE));
+    attributes.push_back(AttributeDesc("treatment", TID_STRING, AttributeDesc::IS_NULLABLE, CompressorType::NONE));
+    attributes.addEmptyTagAttribute();
+
+    Dimensions dimensions;
+    dimensions.push_back(DimensionDesc("instance_id", 0, query->getInstancesCount() - 1, 1, 0));
+    dimensions.push_back(DimensionDesc("entry", 0, CoordinateBounds::getMax(), EXPLAIN_ENTRY_CHUNK, 0));
+
+    return ArrayDesc("secure_scan_explain",
+                     attributes,
+                     dimensions,
+                     createDistribution(dtUndefined),
+                     query->getDefaultArrayResidency());
+}
+
+std::shared_ptr<Array> makeExplainArray(ArrayDesc const& explainSchema,
+                                        ArrayDesc const& dataSchema,
+                                        std::shared_ptr<Array> const& dataArray,
+                                        std::shared_ptr<ChunkPlan> const& plan,
+                                        std::vector<ResolvedPermissions> const& enforced,
+                                        std::shared_ptr<Query> const& query)
+{
+    std::shared_ptr<Array> result = make_shared<MemArray>(explainSchema, query);
+    ExplainWriter writer(result, query);
+
+    // The permissions are the same on every instance
+    if (query->isCoordinator())
+    {
+        for (size_t d = 0; d < enforced.size(); d++)
+        {
+            std::vector<PermissionIntervals::Interval> const& intervals = enforced[d].intervals.intervals();
+            for (size_t i = 0; i < intervals.size(); i++)
+            {
+                writer.setString(EXPLAIN_KIND, "interval");
+                writer.setString(EXPLAIN_DIMENSION, enforced[d].dimName);
+                writer.setInt64(EXPLAIN_LOW, intervals[i].first);
+                writer.setInt64(EXPLAIN_HIGH, intervals[i].second);
+                writer.setUint64(EXPLAIN_COUNT, intervals[i].second - intervals[i].first + 1);
+                writer.write();
+            }
+        }
+        if (plan)
+        {
+            Dimensions const& dataDims = dataSchema.getDimensions();
+            std::vector<ChunkPlan::Dimension> const& planDims = plan->getDimensions();
+            for (size_t d = 0; d < planDims.size(); d++)
+            {
+                writer.setString(EXPLAIN_KIND, "slabs");
+                writer.setString(EXPLAIN_DIMENSION, dataDims[planDims[d].getDimIdx()].getBaseName());
+                writer.setUint64(EXPLAIN_COUNT, planDims[d].getSlabs().size());
+                writer.write();
+            }
+        }
+    }
+
+    // Walk the positions of the local chunks, without reading them
+    Dimensions const& dataDims = dataSchema.getDimensions();
+    std::vector<size_t> hints;
+    size_t nChunks = 0;
+    std::shared_ptr<ConstArrayIterator> aiter =
+        dataArray->getConstIterator(dataSchema.getAttributes().firstDataAttribute());
+    for (; !aiter->end(); ++(*aiter))
+    {
+        Coordinates const& chunkPos = aiter->getPosition();
+        ChunkPlan::Kind const kind = plan ? plan->getKind(chunkPos, hints) : ChunkPlan::PASS_THROUGH;
+        if (kind == ChunkPlan::SKIP)
+        {
+            continue;
+        }
+
+        // Cells of the chunk, times the permitted fraction along each
+        // permission dimension
+        double cells = 1;
+        for (size_t i = 0; i < dataDims.size(); i++)
+        {
+            Coordinate const chunkEnd = std::min(chunkPos[i] + dataDims[i].getChunkInterval() - 1,
+                                                 dataDims[i].getEndMax());
+            cells *= chunkEnd - chunkPos[i] + 1;
+        }
+        if (kind == ChunkPlan::MASKED)
+        {
+            std::vector<ChunkPlan::Dimension> const& planDims = plan->getDimensions();
+            for (size_t d = 0; d < planDims.size(); d++)
+            {
+                size_t const dimIdx = planDims[d].getDimIdx();
+                Coordinate const chunkEnd = std::min(chunkPos[dimIdx] + dataDims[dimIdx].getChunkInterval() - 1,
+                                                     dataDims[dimIdx].getEndMax());
+                cells *= double(planDims[d].countPermitted(chunkPos[dimIdx], chunkEnd)) /
+                    (chunkEnd - chunkPos[dimIdx] + 1);
+            }
+        }
+
+        writer.setString(EXPLAIN_KIND, "chunk");
+        writer.setString(EXPLAIN_CHUNK, formatPosition(chunkPos));
+        writer.setString(EXPLAIN_TREATMENT, kind == ChunkPlan::PASS_THROUGH ? "pass" : "masked");
+        writer.setUint64(EXPLAIN_COUNT, static_cast<uint64_t>(cells + 0.5));
+        writer.write();
+        nChunks++;
+    }
+    writer.flush();
+    LOG4CXX_DEBUG(logger, "secure_scan::explain chunks:" << nChunks);
+    return result;
+}
+
+} //namespace scidb
@@ -0,0 +1,82 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file ExplainArray.h
+ *
+ * @brief The access plan returned by secure_scan(array, true) instead
+ * of the data.
+ *
+ * Each instance returns one cell per entry of the plan, along
+ * [instance_id, entry]:
+ *   - kind 'interval', on the coordinator: a permitted interval
+ *     [low, high] along a permission dimension, with its number of
+ *     coordinates in count.
+ *   - kind 'slabs', on the coordinator: the number of runs of chunk
+ *     slabs along a permission dimension that are not skipped, in
+ *     count.
+ *   - kind 'chunk': the position of a local data chunk that would be
+ *     read, its treatment, 'pass' or 'masked', and the estimated
+ *     number of permitted cells in count, assuming the chunk is dense.
+ * Attributes that do not apply to an entry are null. Only the chunk
+ * positions are read from the data array, never the chunks.
+ */
+
+#ifndef EXPLAIN_ARRAY_H_
+#define EXPLAIN_ARRAY_H_
+
+#include <memory>
+#include <vector>
+
+#include <array/Array.h>
+#include <array/Metadata.h>
+#include <query/Query.h>
+
+#include "ChunkPlan.h"
+#include "Permissions.h"
+
+namespace scidb
+{
+
+ArrayDesc makeExplainSchema(std::shared_ptr<Query> const& query);
+
+/**
+ * @param explainSchema the schema built by makeExplainSchema.
+ * @param dataSchema the schema of the scanned array.
+ * @param plan the chunk plan of the user, null if every chunk is
+ *             passed through.
+ * @param enforced the permissions enforced along each permission
+ *                 dimension.
+ */
+std::shared_ptr<Array> makeExplainArray(ArrayDesc const& explainSchema,
+                                        ArrayDesc const& dataSchema,
+                                        std::shared_ptr<Array> const& dataArray,
+                                        std::shared_ptr<ChunkPlan> const& plan,
+                                        std::vector<ResolvedPermissions> const& enforced,
+                                        std::shared_ptr<Query> const& query);
+
+} //namespace scidb
+
+#endif /* EXPLAIN_ARRAY_H_ */
@@ -23,6 +23,8 @@
 * END_COPYRIGHT
 */
 
+#include <algorithm>
+
 #include <log4cxx/logger.h>
 #include <array/ArrayName.h>
 #include <query/LogicalOperator.h>
@@ -34,6 +36,9 @@
 #include <rbac/Session.h>
 
 #include "settings.h"
+#include "CatalogMemo.h"
+#include "ExplainArray.h"
+#include "Permissions.h"
 
 using namespace std;
 using namespace scidb::namespaces;
@@ -46,17 +51,31 @@ namespace scidb
  * @brief The operator: secure_scan().
  *
  * @par Synopsis:
- *   secure_scan( srcArray )
+ *   secure_scan( srcArray [, explain] [, 'attr'...]
+ *                [, lowCoord1, ..., lowCoordN, highCoord1, ..., highCoordN] )
  *
  * @par Summary:
- *   Produces a result array that is equivalent to a stored array.
+ *   Produces a result array that is equivalent to a stored array,
+ *   optionally restricted to some of its attributes and to a box of
+ *   coordinates.
  *
  * @par Input:
  *   - srcArray: the array to scan, with srcAttrs and srcDims.
+ *   - explain: if true, return the access plan of the user instead of
+ *     the data, see ExplainArray.h. Defaults to false.
+ *   - attr: the names of the attributes to return, as strings, in the
+ *     order of the output. Defaults to all of srcAttrs.
+ *   - the low and high coordinates of the box to return along each of
+ *     srcDims, both included, as in between(). They are intersected
+ *     with the permissions of the user, so chunks outside of the box
+ *     are never read.
+ *
+ *   The optional parameters are told apart by type, so none of them
+ *   may be null: a null would be taken for the explain flag.
  *
  * @par Output array:
  *        <
- *   <br>   srcAttrs
+ *   <br>   srcAttrs, or the listed attributes
  *   <br> >
  *   <br> [
  *   <br>   srcDims
@@ -91,6 +110,12 @@ public:
                  RE(PP(PLACEHOLDER_ARRAY_NAME).setAllowVersions(true)),
                  RE(RE::QMARK, {
                     RE(PP(PLACEHOLDER_CONSTANT, TID_BOOL))
+                 }),
+                 RE(RE::STAR, {
+                    RE(PP(PLACEHOLDER_CONSTANT, TID_STRING))
+                 }),
+                 RE(RE::STAR, {
+                    RE(PP(PLACEHOLDER_CONSTANT, TID_INT64))
                  })
               })
             }
@@ -110,33 +135,13 @@ public:
              _parameters.front())->getObjectName();
         SCIDB_ASSERT(isNameUnversioned(arrayNameOrig));
 
-        ArrayDesc srcDesc;
-        SystemCatalog::GetArrayDescArgs args;
-        query->getNamespaceArrayNames(arrayNameOrig, args.nsName, args.arrayName);
-        args.throwIfNotFound = true;
-        args.result = &srcDesc;
-        SystemCatalog::getInstance()->getArrayDesc(args);
-        if (srcDesc.isTransient())
-        {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "temporary arrays not supported";
-        }
-
-        if (srcDesc.isAutochunked())
-        {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "auto-chunked arrays not supported";
-        }
+        // The scanned array itself is looked up in inferSchema
+        std::string nsName, arrayName;
+        query->getNamespaceArrayNames(arrayNameOrig, nsName, arrayName);
 
-        auto lock = LockDesc::create(
-                                     PERM_NS,
-                                     PERM_ARRAY,
-                                     query->getTxn(),
-                                     LockDesc::COORD,
-                                     LockDesc::RD);
-        std::shared_ptr<LockDesc> resLock = query->getTxn().requestLock(lock);
-        SCIDB_ASSERT(resLock);
-        SCIDB_ASSERT(resLock->getLockMode() >= LockDesc::RD);
+        // The versions of the permissions arrays are pinned by the
+        // physical operator on the coordinator, under these locks
+        lockPermissionsArrays(query);
         /*        const LockDesc::LockMode lockMode = LockDesc::RD;
         std::shared_ptr<LockDesc>  lock(
             make_shared<LockDesc>(
@@ -150,21 +155,20 @@ public:
         SCIDB_ASSERT(resLock);
         SCIDB_ASSERT(resLock->getLockMode() >= LockDesc::RD);*/
 
-        rbac::RightsMap neededRights;
-        neededRights.upsert(rbac::ET_NAMESPACE, args.nsName, rbac::P_NS_READ);
-        try {
-          scidb::namespaces::Communicator::checkAccess(query->getSession().get(),
-                                                       &neededRights);
-          query->getRights()->upsert(rbac::ET_NAMESPACE, args.nsName, rbac::P_NS_READ);
-        } catch (...) {
-          query->getRights()->upsert(rbac::ET_NAMESPACE, args.nsName, rbac::P_NS_LIST);
+        if (CatalogMemo::getInstance()->checkAccess(query,
+                                                    rbac::ET_NAMESPACE,
+                                                    nsName,
+                                                    rbac::P_NS_READ)) {
+          query->getRights()->upsert(rbac::ET_NAMESPACE, nsName, rbac::P_NS_READ);
+        } else {
+          query->getRights()->upsert(rbac::ET_NAMESPACE, nsName, rbac::P_NS_LIST);
         }
     }
 
     ArrayDesc inferSchema(std::vector< ArrayDesc> inputSchemas, std::shared_ptr< Query> query)
     {
         assert(inputSchemas.size() == 0);
-        assert(_parameters.size() == 1);
+        assert(!_parameters.empty());
         assert(_parameters[0]->getParamType() == PARAM_ARRAY_REF);
 
         std::shared_ptr<OperatorParamArrayReference>& arrayRef = (std::shared_ptr<OperatorParamArrayReference>&)_parameters[0];
@@ -183,7 +187,18 @@ public:
         args.versionId = arrayRef->getVersion();
         args.throwIfNotFound = true;
         args.result = &schema;
-        SystemCatalog::getInstance()->getArrayDesc(args);
+        CatalogMemo::getInstance()->getArrayDesc(query, args);
+        if (schema.isTransient())
+        {
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                << "temporary arrays not supported";
+        }
+
+        if (schema.isAutochunked())
+        {
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                << "auto-chunked arrays not supported";
+        }
 
         schema.addAlias(arrayNameOrig);
         schema.setNamespaceName(args.nsName);
@@ -201,37 +216,128 @@ public:
             // Harder case: need to find out if they are assigned to
             // the "admin" role.  Make a temporary Rights object and
             // check to see if we have the rights.
-            rbac::RightsMap neededRights;
-            neededRights.upsert(rbac::ET_DB, "", rbac::P_DB_ADMIN);
-            try {
-                scidb::namespaces::Communicator::checkAccess(query->getSession().get(),
-                                                             &neededRights);
+            if (CatalogMemo::getInstance()->checkAccess(query,
+                                                        rbac::ET_DB,
+                                                        "",
+                                                        rbac::P_DB_ADMIN)) {
                 _privInfo = rbac::DBA_USER;    // Succeeded, user must
                                                // have the admin role.
-            } catch (...) {
-                // checkAccess threw, too bad for yew!
             }
         }
 
         // Check if user has read access on the namespace
         if (_privInfo != rbac::DBA_USER) { // only check if user does
                                            // not have scidbadmin role
-            rbac::RightsMap neededRights;
-            neededRights.upsert(rbac::ET_NAMESPACE, args.nsName, rbac::P_NS_READ);
-            try {
-                scidb::namespaces::Communicator::checkAccess(query->getSession().get(),
-                                                             &neededRights);
+            // Shares the check of inferAccess
+            if (CatalogMemo::getInstance()->checkAccess(query,
+                                                        rbac::ET_NAMESPACE,
+                                                        args.nsName,
+                                                        rbac::P_NS_READ)) {
                 _privInfo = READ_PERM; // Succeeded, user must have
                                        // the read permission on
                                        // namespace.
-            } catch (...) {
-                // checkAccess threw, too bad for yew!
             }
         }
 
+        // The optional parameters are told apart by type, which a null
+        // does not have
+        bool explain = false;
+        std::vector<std::string> attrNames;
+        size_t nBounds = 0;
+        for (size_t i = 1; i < _parameters.size(); i++)
+        {
+            std::shared_ptr<OperatorParamLogicalExpression>& param =
+                (std::shared_ptr<OperatorParamLogicalExpression>&)_parameters[i];
+            TypeId const type = param->getExpectedType().typeId();
+            Value const value = evaluate(param->getExpression(), type);
+            if (value.isNull())
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "optional parameters must not be null";
+            }
+            if (type == TID_BOOL)
+            {
+                explain = value.getBool();
+            }
+            else if (type == TID_STRING)
+            {
+                attrNames.push_back(value.getString());
+            }
+            else
+            {
+                nBounds++;
+            }
+        }
+        if (nBounds != 0 && nBounds != 2 * schema.getDimensions().size())
+        {
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                << "bounds need a low and a high coordinate for each dimension";
+        }
+
+        if (explain)
+        {
+            return makeExplainSchema(query);
+        }
+        if (!attrNames.empty())
+        {
+            ArrayDesc projected = projectSchema(schema, attrNames);
+            projected.addAlias(arrayNameOrig);
+            projected.setNamespaceName(args.nsName);
+            return projected;
+        }
         return schema;
     }
 
+    /**
+     * @return the schema with only the listed attributes, in the order
+     * of the list, and the empty tag.
+     */
+    static ArrayDesc projectSchema(ArrayDesc const& schema,
+                                   std::vector<std::string> const& attrNames)
+    {
+        Attributes attributes;
+        for (size_t i = 0; i < attrNames.size(); i++)
+        {
+            if (std::find(attrNames.begin(), attrNames.begin() + i, attrNames[i]) !=
+                attrNames.begin() + i)
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "attribute listed twice: " << attrNames[i];
+            }
+            bool found = false;
+            for (auto const& attr : schema.getAttributes(true))
+            {
+                if (attr.getName() == attrNames[i])
+                {
+                    attributes.push_back(AttributeDesc(attr.getName(),
+                                                       attr.getType(),
+                                                       attr.getFlags(),
+                                                       attr.getDefaultCompressionMethod(),
+                                                       attr.getAliases(),
+                                                       &attr.getDefaultValue(),
+                                                       attr.getDefaultValueExpr()));
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "scanned array does not have attribute " << attrNames[i];
+            }
+        }
+        if (schema.getAttributes().hasEmptyIndicator())
+        {
+            attributes.addEmptyTagAttribute();
+        }
+
+        return ArrayDesc(schema.getName(),
+                         attributes,
+                         schema.getDimensions(),
+                         schema.getDistribution(),
+                         schema.getResidency());
+    }
+
     std::string getInspectable() const override
     {
         return _privInfo;
@@ -0,0 +1,125 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <query/LogicalOperator.h>
+#include <query/Query.h>
+#include <rbac/Rights.h>
+
+#include "settings.h"
+#include "SecureScanStats.h"
+
+using namespace std;
+
+namespace scidb
+{
+
+/**
+ * @brief The operator: secure_scan_stats().
+ *
+ * @par Synopsis:
+ *   secure_scan_stats()
+ *
+ * @par Summary:
+ *   Returns the runtime statistics of secure_scan on every instance,
+ *   aggregated by user since the plugin was loaded. Only scans of
+ *   users without read permission on the namespace are counted.
+ *
+ * @par Output array:
+ *        <
+ *   <br>   queries: number of scans
+ *   <br>   catalog_usec: time spent looking up the permissions arrays
+ *   <br>   read_usec: time spent reading the local permissions
+ *   <br>   exchange_usec: time spent exchanging the permissions between instances
+ *   <br>   permitted_cells: number of permitted coordinates
+ *   <br>   ranges: number of collapsed permission intervals
+ *   <br>   chunks_probed: number of data chunks looked up, over all attributes
+ *   <br>   chunks_skipped: number of data chunks with no permitted cell
+ *   <br>   chunks_passed: number of data chunks with every cell permitted
+ *   <br>   chunks_masked: number of data chunks with some cells permitted
+ *   <br>   cells_filtered: number of data cells filtered out
+ *   <br> >
+ *   <br> [
+ *   <br>   instance_id, user_id
+ *   <br> ]
+ *
+ * @par Examples:
+ *   aggregate(secure_scan_stats(), sum(read_usec), sum(exchange_usec), user_id)
+ *
+ * @par Errors:
+ *   n/a
+ *
+ * @par Notes:
+ *   Requires the admin role.
+ *
+ */
+class LogicalSecureScanStats: public  LogicalOperator
+{
+public:
+    LogicalSecureScanStats(const std::string& logicalName, const std::string& alias):
+                    LogicalOperator(logicalName, alias)
+    {
+    }
+
+    static PlistSpec const* makePlistSpec()
+    {
+        static PlistSpec argSpec;
+        return &argSpec;
+    }
+
+    void inferAccess(const std::shared_ptr<Query>& query) override
+    {
+        LogicalOperator::inferAccess(query);
+
+        // The statistics show the activity of every user
+        query->getRights()->upsert(rbac::ET_DB, "", rbac::P_DB_ADMIN);
+    }
+
+    ArrayDesc inferSchema(std::vector< ArrayDesc> inputSchemas, std::shared_ptr< Query> query)
+    {
+        assert(inputSchemas.size() == 0);
+
+        Attributes attributes;
+        std::vector<std::string> const& names = SecureScanStats::Counters::getNames();
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            attributes.push_back(AttributeDesc(names[i], TID_UINT64, 0, CompressorType::NONE));
+        }
+        attributes.addEmptyTagAttribute();
+
+        Dimensions dimensions;
+        dimensions.push_back(DimensionDesc("instance_id", 0, query->getInstancesCount() - 1, 1, 0));
+        dimensions.push_back(DimensionDesc(USER_DIM, 0, CoordinateBounds::getMax(), STATS_USER_CHUNK, 0));
+
+        return ArrayDesc("secure_scan_stats",
+                         attributes,
+                         dimensions,
+                         createDistribution(dtUndefined),
+                         query->getDefaultArrayResidency());
+    }
+};
+
+REGISTER_LOGICAL_OPERATOR_FACTORY(LogicalSecureScanStats, "secure_scan_stats");
+
+} //namespace scidb
@@ -0,0 +1,195 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <array/ArrayName.h>
+#include <query/LogicalOperator.h>
+#include <query/Query.h>
+#include <query/Transaction.h>
+#include <query/UserQueryException.h>
+#include <rbac/Rights.h>
+
+#include "settings.h"
+#include "CatalogMemo.h"
+#include "Permissions.h"
+
+using namespace std;
+
+namespace scidb
+{
+
+/**
+ * @brief The operator: secure_scan_users().
+ *
+ * @par Synopsis:
+ *   secure_scan_users( srcArray, userId [, userId]... )
+ *
+ * @par Summary:
+ *   Produces, for each of the given users, the cells of a stored array
+ *   that secure_scan returns to that user. The array is read once and
+ *   each cell is checked against the permissions of every user.
+ *
+ * @par Input:
+ *   - srcArray: the array to scan, with srcAttrs and srcDims.
+ *   - userId: the ID of a user, as listed by list('users').
+ *
+ * @par Output array:
+ *        <
+ *   <br>   srcAttrs
+ *   <br> >
+ *   <br> [
+ *   <br>   user_id, srcDims
+ *   <br> ]
+ *
+ * @par Examples:
+ *   secure_scan_users(secured.DATASET, 2, 3)
+ *
+ * @par Errors:
+ *   n/a
+ *
+ * @par Notes:
+ *   Requires the admin role. The permissions of every user are
+ *   enforced, whatever their rights on the namespace.
+ *
+ */
+class LogicalSecureScanUsers: public  LogicalOperator
+{
+public:
+    LogicalSecureScanUsers(const std::string& logicalName, const std::string& alias):
+                    LogicalOperator(logicalName, alias)
+    {
+    }
+
+    static PlistSpec const* makePlistSpec()
+    {
+        static PlistSpec argSpec {
+            { "", // positionals
+              RE(RE::LIST, {
+                 RE(PP(PLACEHOLDER_ARRAY_NAME).setAllowVersions(true)),
+                 RE(RE::PLUS, {
+                    RE(PP(PLACEHOLDER_CONSTANT, TID_INT64))
+                 })
+              })
+            }
+        };
+        return &argSpec;
+    }
+
+    void inferAccess(const std::shared_ptr<Query>& query) override
+    {
+        LogicalOperator::inferAccess(query);
+
+        // The versions of the permissions arrays are pinned by the
+        // physical operator on the coordinator, under these locks
+        lockPermissionsArrays(query);
+
+        // The output shows the data of other users
+        query->getRights()->upsert(rbac::ET_DB, "", rbac::P_DB_ADMIN);
+    }
+
+    ArrayDesc inferSchema(std::vector< ArrayDesc> inputSchemas, std::shared_ptr< Query> query)
+    {
+        assert(inputSchemas.size() == 0);
+        assert(_parameters.size() >= 2);
+        assert(_parameters[0]->getParamType() == PARAM_ARRAY_REF);
+
+        if (_parameters.size() - 1 > PERM_SCAN_USERS_MAX)
+        {
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                << "more than " << PERM_SCAN_USERS_MAX << " user IDs";
+        }
+        for (size_t i = 1; i < _parameters.size(); i++)
+        {
+            std::shared_ptr<OperatorParamLogicalExpression>& param =
+                (std::shared_ptr<OperatorParamLogicalExpression>&)_parameters[i];
+            Value const userId = evaluate(param->getExpression(), TID_INT64);
+            if (userId.isNull() || userId.getInt64() < 0)
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "user IDs must not be null or negative";
+            }
+        }
+
+        std::shared_ptr<OperatorParamArrayReference>& arrayRef = (std::shared_ptr<OperatorParamArrayReference>&)_parameters[0];
+        assert(ArrayDesc::isNameUnversioned(arrayRef->getObjectName()));
+
+        if (arrayRef->getVersion() == ALL_VERSIONS) {
+            throw USER_QUERY_EXCEPTION(SCIDB_SE_INFER_SCHEMA, SCIDB_LE_WRONG_ASTERISK_USAGE2, _parameters[0]->getParsingContext());
+        }
+        ArrayDesc schema;
+        const std::string &arrayNameOrig = arrayRef->getObjectName();
+
+        SystemCatalog::GetArrayDescArgs args;
+        query->getNamespaceArrayNames(arrayNameOrig, args.nsName, args.arrayName);
+        args.catalogVersion = query->getTxn().getCatalogVersion(args.nsName, args.arrayName);
+        args.versionId = arrayRef->getVersion();
+        args.throwIfNotFound = true;
+        args.result = &schema;
+        CatalogMemo::getInstance()->getArrayDesc(query, args);
+        if (schema.isTransient())
+        {
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                << "temporary arrays not supported";
+        }
+        if (schema.isAutochunked())
+        {
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                << "auto-chunked arrays not supported";
+        }
+
+        size_t userDimIdx = 0;
+        if (findDimension(schema.getDimensions(), USER_DIM, userDimIdx))
+        {
+            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                << "scanned array already has an user ID dimension";
+        }
+
+        // One chunk per user, in front of the chunks of the array. The
+        // overlaps are not filled in the output.
+        Dimensions dimensions;
+        dimensions.push_back(DimensionDesc(USER_DIM, 0, CoordinateBounds::getMax(), 1, 0));
+        Dimensions const& srcDims = schema.getDimensions();
+        for (size_t i = 0; i < srcDims.size(); i++)
+        {
+            dimensions.push_back(srcDims[i]);
+            dimensions.back().setChunkOverlap(0);
+        }
+
+        Attributes attributes = schema.getAttributes();
+        if (!attributes.hasEmptyIndicator())
+        {
+            attributes.addEmptyTagAttribute();
+        }
+
+        return ArrayDesc(arrayNameOrig,
+                         attributes,
+                         dimensions,
+                         createDistribution(dtUndefined),
+                         query->getDefaultArrayResidency());
+    }
+};
+
+REGISTER_LOGICAL_OPERATOR_FACTORY(LogicalSecureScanUsers, "secure_scan_users");
+
+} //namespace scidb
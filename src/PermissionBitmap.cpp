@@ -0,0 +1,205 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include "settings.h"
+#include "PermissionBitmap.h"
+
+using namespace std;
+
+namespace scidb
+{
+
+const size_t PermissionBitmap::ARRAY_MAX;
+
+PermissionBitmap::PermissionBitmap(PermissionIntervals const& intervals)
+    : _cardinality(0)
+{
+    vector<PermissionIntervals::Interval> const& items = intervals.intervals();
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        // Split the interval on container boundaries
+        Coordinate low = items[i].first;
+        Coordinate const high = items[i].second;
+        while (true)
+        {
+            Coordinate const key = keyOf(low);
+            Coordinate const to = std::min(high, (key + 1) * CONTAINER_SIZE - 1);
+            if (_containers.empty() || _containers.back().key != key)
+            {
+                _containers.push_back(Container());
+                _containers.back().key = key;
+            }
+            addRange(offsetOf(low), offsetOf(to));
+            _cardinality += to - low + 1;
+            if (to == high)
+            {
+                break;
+            }
+            low = to + 1;
+        }
+    }
+
+    if (PERM_BLOOM_BITS_PER_VALUE > 0 && _cardinality <= PERM_BLOOM_MAX_VALUES)
+    {
+        _bloom = make_shared<PermissionBloom>(intervals, PERM_BLOOM_BITS_PER_VALUE);
+    }
+}
+
+void PermissionBitmap::addRange(uint16_t from, uint16_t to)
+{
+    Container& container = _containers.back();
+    if (!container.isBitmap() &&
+        container.values.size() + (to - from + 1) > ARRAY_MAX)
+    {
+        // Convert to a bitmap container
+        container.words.assign(CONTAINER_WORDS, 0);
+        for (size_t i = 0; i < container.values.size(); i++)
+        {
+            uint16_t const v = container.values[i];
+            container.words[v / 64] |= uint64_t(1) << (v % 64);
+        }
+        vector<uint16_t>().swap(container.values);
+    }
+
+    if (container.isBitmap())
+    {
+        for (uint32_t v = from; v <= to; v++)
+        {
+            container.words[v / 64] |= uint64_t(1) << (v % 64);
+        }
+    }
+    else
+    {
+        for (uint32_t v = from; v <= to; v++)
+        {
+            container.values.push_back(static_cast<uint16_t>(v));
+        }
+    }
+}
+
+namespace
+{
+    template<typename C>
+    bool containerBefore(C const& container, Coordinate key)
+    {
+        return container.key < key;
+    }
+}
+
+bool PermissionBitmap::contains(Coordinate coord) const
+{
+    size_t hint = _containers.size();
+    return contains(coord, hint);
+}
+
+bool PermissionBitmap::contains(Coordinate coord, size_t& hint) const
+{
+    if (_bloom && !_bloom->mayContain(coord))
+    {
+        return false;
+    }
+
+    Coordinate const key = keyOf(coord);
+    if (hint >= _containers.size() || _containers[hint].key != key)
+    {
+        vector<Container>::const_iterator it =
+            std::lower_bound(_containers.begin(), _containers.end(), key, containerBefore<Container>);
+        if (it == _containers.end() || it->key != key)
+        {
+            return false;
+        }
+        hint = it - _containers.begin();
+    }
+
+    Container const& container = _containers[hint];
+    uint16_t const v = offsetOf(coord);
+    if (container.isBitmap())
+    {
+        return (container.words[v / 64] >> (v % 64)) & 1;
+    }
+    return std::binary_search(container.values.begin(), container.values.end(), v);
+}
+
+void PermissionBitmap::buildMask(Coordinate low, Coordinate high, vector<bool>& mask) const
+{
+    SCIDB_ASSERT(low <= high);
+    mask.assign(high - low + 1, false);
+
+    vector<Container>::const_iterator it =
+        std::lower_bound(_containers.begin(), _containers.end(), keyOf(low), containerBefore<Container>);
+    for (; it != _containers.end() && it->key <= keyOf(high); ++it)
+    {
+        Coordinate const base = it->key * CONTAINER_SIZE;
+        if (it->isBitmap())
+        {
+            Coordinate const from = std::max(low, base);
+            Coordinate const to = std::min(high, base + Coordinate(CONTAINER_MASK));
+            for (Coordinate c = from; c <= to; c++)
+            {
+                uint16_t const v = offsetOf(c);
+                if ((it->words[v / 64] >> (v % 64)) & 1)
+                {
+                    mask[c - low] = true;
+                }
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < it->values.size(); i++)
+            {
+                Coordinate const c = base + it->values[i];
+                if (c >= low && c <= high)
+                {
+                    mask[c - low] = true;
+                }
+            }
+        }
+    }
+}
+
+size_t PermissionBitmap::getMemorySize() const
+{
+    size_t size = _containers.size() * sizeof(Container);
+    for (size_t i = 0; i < _containers.size(); i++)
+    {
+        size += _containers[i].values.size() * sizeof(uint16_t);
+        size += _containers[i].words.size() * sizeof(uint64_t);
+    }
+    if (_bloom)
+    {
+        size += _bloom->getMemorySize();
+    }
+    return size;
+}
+
+bool PermissionBitmap::isFragmented(size_t nIntervals, uint64_t cardinality)
+{
+    return nIntervals >= PERM_BITMAP_MIN_INTERVALS &&
+        cardinality <= nIntervals * PERM_BITMAP_MAX_AVG_RUN;
+}
+
+} //namespace scidb
@@ -0,0 +1,135 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionBitmap.h
+ *
+ * @brief A compressed bitmap of the permitted coordinates, used instead
+ * of the intervals when the permissions are fragmented.
+ *
+ * The layout follows Roaring bitmaps: the coordinates are split on
+ * their high bits into containers of 2^16 values. A container with few
+ * values keeps them as a sorted array of 16-bit offsets, a container
+ * with many values keeps a plain 2^16-bit bitmap.
+ *
+ * Unless the set is too large, a PermissionBloom runs in front of the
+ * containers, so most coordinates that are not permitted are rejected
+ * without searching them.
+ */
+
+#ifndef PERMISSION_BITMAP_H_
+#define PERMISSION_BITMAP_H_
+
+#include <memory>
+#include <vector>
+
+#include <array/Metadata.h>
+
+#include "PermissionBloom.h"
+#include "PermissionIntervals.h"
+
+namespace scidb
+{
+
+class PermissionBitmap
+{
+public:
+    explicit PermissionBitmap(PermissionIntervals const& intervals);
+
+    bool contains(Coordinate coord) const;
+
+    /**
+     * @param hint the container of the previous call, for faster
+     *             lookups when nearby coordinates are tested in turn.
+     */
+    bool contains(Coordinate coord, size_t& hint) const;
+
+    /**
+     * Build the mask of the permitted coordinates in [low, high]:
+     * mask[i] is set if low + i is permitted.
+     */
+    void buildMask(Coordinate low, Coordinate high, std::vector<bool>& mask) const;
+
+    uint64_t cardinality() const
+    {
+        return _cardinality;
+    }
+
+    size_t getMemorySize() const;
+
+    /**
+     * @return true if a set with this many intervals and values is
+     * better stored as a bitmap than as intervals.
+     */
+    static bool isFragmented(size_t nIntervals, uint64_t cardinality);
+
+private:
+    static const int      CONTAINER_BITS = 16;
+    static const int64_t  CONTAINER_SIZE = int64_t(1) << CONTAINER_BITS;
+    static const uint64_t CONTAINER_MASK = CONTAINER_SIZE - 1;
+    static const size_t   CONTAINER_WORDS = CONTAINER_SIZE / 64;
+
+    /**
+     * Array containers larger than this are converted to bitmap
+     * containers, which are smaller from this size on.
+     */
+    static const size_t   ARRAY_MAX = 4096;
+
+    struct Container
+    {
+        Coordinate            key;
+        std::vector<uint16_t> values;
+        std::vector<uint64_t> words;
+
+        bool isBitmap() const
+        {
+            return !words.empty();
+        }
+    };
+
+    static Coordinate keyOf(Coordinate coord)
+    {
+        return coord >> CONTAINER_BITS;
+    }
+
+    static uint16_t offsetOf(Coordinate coord)
+    {
+        return static_cast<uint16_t>(coord & CONTAINER_MASK);
+    }
+
+    /**
+     * Add [from, to] to the last container.
+     * @pre from and to have the key of the last container.
+     */
+    void addRange(uint16_t from, uint16_t to);
+
+    std::vector<Container> _containers;
+    uint64_t               _cardinality;
+    std::shared_ptr<PermissionBloom const> _bloom;
+};
+
+} //namespace scidb
+
+#endif /* PERMISSION_BITMAP_H_ */
@@ -0,0 +1,58 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include "PermissionBloom.h"
+
+using namespace std;
+
+namespace scidb
+{
+
+PermissionBloom::PermissionBloom(PermissionIntervals const& intervals, size_t bitsPerValue)
+{
+    // A power of two number of words, so a word is chosen with a mask
+    uint64_t const nBits = std::max<uint64_t>(intervals.cardinality() * bitsPerValue, 64);
+    size_t nWords = 1;
+    while (nWords * 64 < nBits)
+    {
+        nWords *= 2;
+    }
+    _words.assign(nWords, 0);
+    _wordMask = nWords - 1;
+
+    vector<PermissionIntervals::Interval> const& items = intervals.intervals();
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        for (Coordinate coord = items[i].first; coord <= items[i].second; coord++)
+        {
+            uint64_t const hash = fmix(static_cast<uint64_t>(coord));
+            _words[hash & _wordMask] |= bitsOf(hash);
+        }
+    }
+}
+
+} //namespace scidb
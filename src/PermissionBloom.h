@@ -0,0 +1,98 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionBloom.h
+ *
+ * @brief A Bloom filter of the permitted coordinates, run in front of
+ * the exact membership check of a PermissionBitmap.
+ *
+ * When the grants of a user are scattered over a large space, most
+ * cells of a masked chunk are not permitted, and the exact check costs
+ * a search among the containers of the bitmap for each of them. The
+ * filter rejects most of those cells with one hash and one memory
+ * access: it is blocked, so all the bits of a coordinate are in the same
+ * 64-bit word, chosen by the low bits of the MurmurHash3 finalizer of
+ * the coordinate while its high bits choose the bits in the word.
+ */
+
+#ifndef PERMISSION_BLOOM_H_
+#define PERMISSION_BLOOM_H_
+
+#include <vector>
+
+#include <array/Metadata.h>
+#include <MurmurHash/MurmurHash3.h>
+
+#include "PermissionIntervals.h"
+
+namespace scidb
+{
+
+class PermissionBloom
+{
+public:
+    /**
+     * @param bitsPerValue the size of the filter, for each permitted
+     *                     coordinate.
+     */
+    PermissionBloom(PermissionIntervals const& intervals, size_t bitsPerValue);
+
+    /**
+     * @return false if the coordinate is not permitted, true if it may
+     * be.
+     */
+    bool mayContain(Coordinate coord) const
+    {
+        uint64_t const hash = fmix(static_cast<uint64_t>(coord));
+        uint64_t const bits = bitsOf(hash);
+        return (_words[hash & _wordMask] & bits) == bits;
+    }
+
+    size_t getMemorySize() const
+    {
+        return _words.size() * sizeof(uint64_t);
+    }
+
+private:
+    /**
+     * The bits of a hash in its word: four 6-bit positions taken from
+     * the high half of the hash.
+     */
+    static uint64_t bitsOf(uint64_t hash)
+    {
+        return (uint64_t(1) << ((hash >> 32) & 63)) |
+            (uint64_t(1) << ((hash >> 40) & 63)) |
+            (uint64_t(1) << ((hash >> 48) & 63)) |
+            (uint64_t(1) << ((hash >> 56) & 63));
+    }
+
+    std::vector<uint64_t> _words;
+    uint64_t              _wordMask;
+};
+
+} //namespace scidb
+
+#endif /* PERMISSION_BLOOM_H_ */
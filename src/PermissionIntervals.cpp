@@ -0,0 +1,219 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+#include <log4cxx/logger.h>
+
+#include "PermissionIntervals.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+void PermissionIntervals::Builder::add(Coordinate low, Coordinate high)
+{
+    if (_runs.empty() || low < _runs.back()._intervals.back().first)
+    {
+        // Out of order, start a new run
+        _runs.push_back(PermissionIntervals());
+    }
+    _runs.back().append(low, high);
+}
+
+void PermissionIntervals::Builder::add(PermissionIntervals const& intervals)
+{
+    vector<Interval> const& items = intervals._intervals;
+    for (vector<Interval>::const_iterator it = items.begin(); it != items.end(); ++it)
+    {
+        add(it->first, it->second);
+    }
+}
+
+PermissionIntervals PermissionIntervals::Builder::finish()
+{
+    PermissionIntervals result;
+    if (_runs.size() == 1)
+    {
+        result._intervals.swap(_runs.front()._intervals);
+    }
+    else if (_runs.size() > 1)
+    {
+        LOG4CXX_DEBUG(logger, "secure_scan::merging interval runs:" << _runs.size());
+
+        // Min-heap of the next interval of each run, as (interval, run)
+        typedef pair<Interval, size_t> Head;
+        priority_queue<Head, vector<Head>, greater<Head> > heads;
+        vector<size_t> next(_runs.size(), 1);
+        for (size_t r = 0; r < _runs.size(); r++)
+        {
+            heads.push(Head(_runs[r]._intervals.front(), r));
+        }
+        while (!heads.empty())
+        {
+            Head const head = heads.top();
+            heads.pop();
+            result.append(head.first.first, head.first.second);
+
+            size_t const r = head.second;
+            vector<Interval>& run = _runs[r]._intervals;
+            if (next[r] < run.size())
+            {
+                heads.push(Head(run[next[r]++], r));
+            }
+            else
+            {
+                vector<Interval>().swap(run);
+            }
+        }
+    }
+    _runs.clear();
+    return result;
+}
+
+void PermissionIntervals::append(Coordinate low, Coordinate high)
+{
+    SCIDB_ASSERT(low <= high);
+    if (!_intervals.empty())
+    {
+        Interval& last = _intervals.back();
+        SCIDB_ASSERT(low >= last.first);
+        if (low <= last.second + 1)
+        {
+            // Overlapping or sequential, just update the end
+            last.second = std::max(last.second, high);
+            return;
+        }
+    }
+    _intervals.push_back(Interval(low, high));
+}
+
+void PermissionIntervals::merge(PermissionIntervals const& other)
+{
+    if (other.empty())
+    {
+        return;
+    }
+    if (empty())
+    {
+        _intervals = other._intervals;
+        return;
+    }
+
+    vector<Interval> mine;
+    mine.swap(_intervals);
+    _intervals.reserve(mine.size() + other.size());
+
+    vector<Interval>::const_iterator it1 = mine.begin();
+    vector<Interval>::const_iterator it2 = other._intervals.begin();
+    while (it1 != mine.end() || it2 != other._intervals.end())
+    {
+        if (it2 == other._intervals.end() ||
+            (it1 != mine.end() && it1->first <= it2->first))
+        {
+            append(it1->first, it1->second);
+            ++it1;
+        }
+        else
+        {
+            append(it2->first, it2->second);
+            ++it2;
+        }
+    }
+}
+
+void PermissionIntervals::clip(Coordinate low, Coordinate high)
+{
+    vector<Interval> mine;
+    mine.swap(_intervals);
+    for (size_t i = 0; i < mine.size(); i++)
+    {
+        Coordinate const from = std::max(mine[i].first, low);
+        Coordinate const to = std::min(mine[i].second, high);
+        if (from <= to)
+        {
+            _intervals.push_back(Interval(from, to));
+        }
+    }
+}
+
+uint64_t PermissionIntervals::cardinality() const
+{
+    uint64_t result = 0;
+    for (vector<Interval>::const_iterator it = _intervals.begin(); it != _intervals.end(); ++it)
+    {
+        result += it->second - it->first + 1;
+    }
+    return result;
+}
+
+size_t PermissionIntervals::getSerializedSize() const
+{
+    return sizeof(uint64_t) + _intervals.size() * 2 * sizeof(Coordinate);
+}
+
+void PermissionIntervals::serialize(void* buf) const
+{
+    char* dst = static_cast<char*>(buf);
+    uint64_t const count = _intervals.size();
+    memcpy(dst, &count, sizeof(count));
+    dst += sizeof(count);
+    for (vector<Interval>::const_iterator it = _intervals.begin(); it != _intervals.end(); ++it)
+    {
+        memcpy(dst, &it->first, sizeof(Coordinate));
+        dst += sizeof(Coordinate);
+        memcpy(dst, &it->second, sizeof(Coordinate));
+        dst += sizeof(Coordinate);
+    }
+}
+
+PermissionIntervals PermissionIntervals::deserialize(void const* buf, size_t size)
+{
+    char const* src = static_cast<char const*>(buf);
+    uint64_t count = 0;
+    SCIDB_ASSERT(size >= sizeof(count));
+    memcpy(&count, src, sizeof(count));
+    src += sizeof(count);
+    SCIDB_ASSERT(size == sizeof(count) + count * 2 * sizeof(Coordinate));
+
+    PermissionIntervals result;
+    result._intervals.reserve(count);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        Coordinate low, high;
+        memcpy(&low, src, sizeof(Coordinate));
+        src += sizeof(Coordinate);
+        memcpy(&high, src, sizeof(Coordinate));
+        src += sizeof(Coordinate);
+        result.append(low, high);
+    }
+    return result;
+}
+
+} //namespace scidb
@@ -0,0 +1,142 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionIntervals.h
+ *
+ * @brief The collapsed set of coordinates a user may read along the
+ * permission dimension.
+ *
+ * The intervals are kept sorted, disjoint and non-adjacent, so the set
+ * has exactly one representation and two sets can be compared or
+ * merged in linear time.
+ */
+
+#ifndef PERMISSION_INTERVALS_H_
+#define PERMISSION_INTERVALS_H_
+
+#include <utility>
+#include <vector>
+
+#include <array/Metadata.h>
+
+namespace scidb
+{
+
+class PermissionIntervals
+{
+public:
+    typedef std::pair<Coordinate, Coordinate> Interval;
+
+    PermissionIntervals()
+    {}
+
+    /**
+     * Builds a set from intervals streamed in any order without
+     * sorting them. Intervals arriving in order are coalesced into the
+     * current run as they come; an interval that starts before the
+     * last one starts a new run, and the runs are merged at the end.
+     * Since the chunks of the permissions array usually arrive in order
+     * along the permission dimension, there is usually a single run and
+     * memory stays proportional to the number of intervals, never to
+     * the number of permitted coordinates.
+     */
+    class Builder
+    {
+    public:
+        void add(Coordinate low, Coordinate high);
+
+        /**
+         * Add every interval of a set.
+         */
+        void add(PermissionIntervals const& intervals);
+
+        /**
+         * @return the built set, merging the runs with a k-way merge
+         * if there are several. The builder is left empty.
+         */
+        PermissionIntervals finish();
+
+        size_t getRunCount() const
+        {
+            return _runs.size();
+        }
+
+    private:
+        std::vector<PermissionIntervals> _runs;
+    };
+
+    /**
+     * Add [low, high] to the end of the set, coalescing it with the
+     * last interval if they overlap or are adjacent.
+     * @pre low is not less than the low end of the last interval.
+     */
+    void append(Coordinate low, Coordinate high);
+
+    /**
+     * Add every interval of other to the set.
+     */
+    void merge(PermissionIntervals const& other);
+
+    /**
+     * Remove the coordinates outside of [low, high] from the set.
+     */
+    void clip(Coordinate low, Coordinate high);
+
+    bool empty() const
+    {
+        return _intervals.empty();
+    }
+
+    size_t size() const
+    {
+        return _intervals.size();
+    }
+
+    std::vector<Interval> const& intervals() const
+    {
+        return _intervals;
+    }
+
+    /**
+     * @return the number of coordinates in the set.
+     */
+    uint64_t cardinality() const;
+
+    /**
+     * The set is serialized as the number of intervals followed by the
+     * low and high coordinate of each interval.
+     */
+    size_t getSerializedSize() const;
+    void serialize(void* buf) const;
+    static PermissionIntervals deserialize(void const* buf, size_t size);
+
+private:
+    std::vector<Interval> _intervals;
+};
+
+} //namespace scidb
+
+#endif /* PERMISSION_INTERVALS_H_ */
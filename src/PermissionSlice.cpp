@@ -0,0 +1,312 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include <array/RLE.h>
+
+#include "PermissionSlice.h"
+
+using namespace std;
+
+namespace scidb
+{
+
+/**
+ * Up to 56 bits are loaded at a time so that an unaligned load never
+ * spans more than 8 bytes.
+ */
+static const uint64_t LOAD_BITS = 56;
+
+/**
+ * Load count bits starting at bit pos, reading only the bytes they
+ * span.
+ */
+static uint64_t loadBits(uint8_t const* bits, uint64_t pos, uint64_t count)
+{
+    uint8_t const* p = bits + (pos >> 3);
+    uint64_t const shift = pos & 7;
+    uint64_t const nBytes = (shift + count + 7) >> 3;
+    uint64_t word = 0;
+    for (uint64_t b = 0; b < nBytes; b++)
+    {
+        word |= uint64_t(p[b]) << (8 * b);
+    }
+    return (word >> shift) & ((uint64_t(1) << count) - 1);
+}
+
+void findBitRuns(uint8_t const* bits, uint64_t start, uint64_t count, vector<BitRun>& runs)
+{
+    runs.clear();
+    bool inRun = false;
+    uint64_t runStart = 0;
+    for (uint64_t i = 0; i < count; )
+    {
+        uint64_t const n = std::min(LOAD_BITS, count - i);
+        uint64_t const mask = (uint64_t(1) << n) - 1;
+        uint64_t const word = loadBits(bits, start + i, n);
+
+        // Jump from one transition to the next within the word
+        uint64_t j = 0;
+        while (j < n)
+        {
+            uint64_t const pending = (inRun ? ~word : word) & mask & ~((uint64_t(1) << j) - 1);
+            if (pending == 0)
+            {
+                break;
+            }
+            j = __builtin_ctzll(pending);
+            if (inRun)
+            {
+                runs.push_back(BitRun(runStart, i + j - 1));
+            }
+            else
+            {
+                runStart = i + j;
+            }
+            inRun = !inRun;
+        }
+        i += n;
+    }
+    if (inRun)
+    {
+        runs.push_back(BitRun(runStart, count - 1));
+    }
+}
+
+/**
+ * Walks the segments of the payload of a chunk in order and finds the
+ * runs of true values in a range of payload positions.
+ */
+class TrueRunFinder
+{
+public:
+    explicit TrueRunFinder(ConstRLEPayload const& payload)
+        : _payload(payload),
+          _bits(reinterpret_cast<uint8_t const*>(payload.getFixedValues())),
+          _segIdx(0)
+    {}
+
+    /**
+     * @param[out] runs set to the [first, last] payload position of
+     *                  each run of true values in [begin, end).
+     * @pre begin is not less than the begin of the previous call.
+     */
+    void find(position_t begin, position_t end, vector<BitRun>& runs)
+    {
+        runs.clear();
+        size_t const nSegs = _payload.nSegments();
+        while (_segIdx < nSegs && segmentEnd(_segIdx) <= begin)
+        {
+            _segIdx++;
+        }
+        for (size_t s = _segIdx; s < nSegs; s++)
+        {
+            ConstRLEPayload::Segment const& seg = _payload.getSegment(s);
+            if (seg._pPosition >= end)
+            {
+                break;
+            }
+            position_t const from = std::max(begin, seg._pPosition);
+            position_t const to = std::min(end, segmentEnd(s));
+            if (seg._null)
+            {
+                continue;
+            }
+            if (seg._same)
+            {
+                if (isSet(seg._valueIndex))
+                {
+                    appendRun(from, to - 1, runs);
+                }
+                continue;
+            }
+            findBitRuns(_bits, seg._valueIndex + (from - seg._pPosition), to - from, _segRuns);
+            for (size_t r = 0; r < _segRuns.size(); r++)
+            {
+                appendRun(from + _segRuns[r].first, from + _segRuns[r].second, runs);
+            }
+        }
+    }
+
+private:
+    position_t segmentEnd(size_t s) const
+    {
+        return (s + 1 < _payload.nSegments())
+            ? _payload.getSegment(s + 1)._pPosition
+            : _payload.count();
+    }
+
+    bool isSet(uint64_t bit) const
+    {
+        return (_bits[bit >> 3] & (1 << (bit & 7))) != 0;
+    }
+
+    /**
+     * Append a run, coalescing it with the previous one across
+     * segments.
+     */
+    static void appendRun(position_t first, position_t last, vector<BitRun>& runs)
+    {
+        if (!runs.empty() && runs.back().second + 1 == BitRun::second_type(first))
+        {
+            runs.back().second = last;
+        }
+        else
+        {
+            runs.push_back(BitRun(first, last));
+        }
+    }
+
+    ConstRLEPayload const& _payload;
+    uint8_t const*         _bits;
+    size_t                 _segIdx;
+    vector<BitRun>         _segRuns;
+};
+
+/**
+ * Keeps the chunk pinned while its payload is read.
+ */
+class ChunkPin
+{
+public:
+    explicit ChunkPin(ConstChunk const& chunk)
+        : _chunk(chunk),
+          _pinned(chunk.pin())
+    {}
+
+    ~ChunkPin()
+    {
+        if (_pinned)
+        {
+            _chunk.unPin();
+        }
+    }
+
+private:
+    ConstChunk const& _chunk;
+    bool              _pinned;
+};
+
+bool readPermissionSlice(ConstChunk const& chunk,
+                         size_t userDimIdx,
+                         size_t permDimIdx,
+                         Coordinate userId,
+                         PermissionIntervals::Builder& builder)
+{
+    ChunkPin pin(chunk);
+    char const* data = static_cast<char const*>(chunk.getConstData());
+    if (data == NULL || chunk.getAttributeDesc().getType() != TID_BOOL)
+    {
+        return false;
+    }
+    ConstRLEPayload payload(data);
+    if (!payload.isBool())
+    {
+        return false;
+    }
+
+    // The logical positions of the empty bitmap are row-major in the
+    // chunk box, overlaps included
+    Coordinates const& first = chunk.getFirstPosition(true);
+    Coordinates const& last = chunk.getLastPosition(true);
+    size_t const nDims = first.size();
+    size_t const innerIdx = nDims - 1;
+    position_t const rowLength = last[innerIdx] - first[innerIdx] + 1;
+
+    std::shared_ptr<ConstRLEEmptyBitmap> emptyBitmap = chunk.getEmptyBitmap();
+    size_t const nEmptySegs = emptyBitmap ? emptyBitmap->nSegments() : 1;
+
+    TrueRunFinder finder(payload);
+    vector<BitRun> runs;
+    Coordinates rowCoords(nDims);
+    for (size_t e = 0; e < nEmptySegs; e++)
+    {
+        position_t lPosition = 0;
+        position_t pPosition = 0;
+        position_t length = payload.count();
+        if (emptyBitmap)
+        {
+            ConstRLEEmptyBitmap::Segment const& seg = emptyBitmap->getSegment(e);
+            lPosition = seg._lPosition;
+            pPosition = seg._pPosition;
+            length = seg._length;
+        }
+
+        // Split the segment into pieces of rows along the inner dimension
+        while (length > 0)
+        {
+            position_t row = lPosition / rowLength;
+            position_t const col = lPosition % rowLength;
+            position_t const pieceLength = std::min(length, rowLength - col);
+            for (size_t i = innerIdx; i-- > 0; )
+            {
+                position_t const extent = last[i] - first[i] + 1;
+                rowCoords[i] = first[i] + row % extent;
+                row /= extent;
+            }
+
+            // Clip the piece to the user row
+            Coordinate lowInner = first[innerIdx] + col;
+            Coordinate highInner = lowInner + pieceLength - 1;
+            bool inUserRow = true;
+            if (userDimIdx == innerIdx)
+            {
+                inUserRow = (userId >= lowInner && userId <= highInner);
+                lowInner = highInner = userId;
+            }
+            else
+            {
+                inUserRow = (rowCoords[userDimIdx] == userId);
+            }
+
+            if (inUserRow)
+            {
+                position_t const from = pPosition + (lowInner - first[innerIdx] - col);
+                finder.find(from, from + (highInner - lowInner + 1), runs);
+                if (permDimIdx == innerIdx)
+                {
+                    Coordinate const base = lowInner - from;
+                    for (size_t r = 0; r < runs.size(); r++)
+                    {
+                        builder.add(base + Coordinate(runs[r].first),
+                                    base + Coordinate(runs[r].second));
+                    }
+                }
+                else if (!runs.empty())
+                {
+                    builder.add(rowCoords[permDimIdx], rowCoords[permDimIdx]);
+                }
+            }
+
+            lPosition += pieceLength;
+            pPosition += pieceLength;
+            length -= pieceLength;
+        }
+    }
+    return true;
+}
+
+} //namespace scidb
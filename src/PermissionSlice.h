@@ -0,0 +1,78 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionSlice.h
+ *
+ * @brief Bulk extraction of the permitted coordinates of a user from
+ * the chunks of the permissions array.
+ *
+ * Instead of visiting the cells one by one through a chunk iterator,
+ * the runs of the empty bitmap are walked row by row and the runs of
+ * true values are found in the RLE payload, scanning the bit-packed
+ * booleans a word at a time. Each run of true cells along the
+ * permission dimension is emitted as one interval.
+ */
+
+#ifndef PERMISSION_SLICE_H_
+#define PERMISSION_SLICE_H_
+
+#include <utility>
+#include <vector>
+
+#include <array/Array.h>
+#include <array/Metadata.h>
+
+#include "PermissionIntervals.h"
+
+namespace scidb
+{
+
+typedef std::pair<uint64_t, uint64_t> BitRun;
+
+/**
+ * Find the runs of set bits in bits [start, start + count), the bits
+ * being packed least significant first.
+ * @param[out] runs set to the [first, last] bit of each run, relative
+ *                  to start.
+ */
+void findBitRuns(uint8_t const* bits, uint64_t start, uint64_t count, std::vector<BitRun>& runs);
+
+/**
+ * Add the permitted coordinates of a user in a chunk of the
+ * permissions array to a builder, as intervals.
+ * @return false if the chunk payload cannot be read in bulk, in which
+ *         case nothing is added and the caller should iterate over the
+ *         cells.
+ */
+bool readPermissionSlice(ConstChunk const& chunk,
+                         size_t userDimIdx,
+                         size_t permDimIdx,
+                         Coordinate userId,
+                         PermissionIntervals::Builder& builder);
+
+} //namespace scidb
+
+#endif /* PERMISSION_SLICE_H_ */
@@ -0,0 +1,70 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionSource.h
+ *
+ * @brief Where the permitted coordinates of a user come from.
+ *
+ * The permission kernel, i.e. collapsing the cells of the permissions
+ * array into intervals, mapping them onto the data chunks and testing
+ * cells, only depends on this interface, so it can be exercised with a
+ * synthetic source and no SciDB instance, see PermissionsBenchmark.cpp.
+ */
+
+#ifndef PERMISSION_SOURCE_H_
+#define PERMISSION_SOURCE_H_
+
+#include "PermissionIntervals.h"
+
+namespace scidb
+{
+
+class PermissionSource
+{
+public:
+    virtual ~PermissionSource()
+    {}
+
+    /**
+     * Add the permitted coordinates of the user to a builder, as cells
+     * or intervals, in any order.
+     */
+    virtual void addTo(PermissionIntervals::Builder& builder) = 0;
+
+    /**
+     * @return the collapsed permitted coordinates of the user.
+     */
+    PermissionIntervals read()
+    {
+        PermissionIntervals::Builder builder;
+        addTo(builder);
+        return builder.finish();
+    }
+};
+
+} //namespace scidb
+
+#endif /* PERMISSION_SOURCE_H_ */
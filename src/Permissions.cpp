@@ -0,0 +1,742 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include <log4cxx/logger.h>
+#include <array/DBArray.h>
+#include <array/MemoryBuffer.h>
+#include <network/Network.h>
+#include <query/Transaction.h>
+#include <system/SystemCatalog.h>
+
+#include "settings.h"
+#include "CatalogMemo.h"
+#include "Permissions.h"
+#include "PermissionSlice.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+bool findDimension(Dimensions const& dims, std::string const& name, size_t& idx)
+{
+    for (size_t i = 0; i < dims.size(); i++)
+    {
+        if (dims[i].hasNameAndAlias(name))
+        {
+            idx = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool findPermissionsLayout(ArrayDesc const& permSchema,
+                           std::string const& permDimName,
+                           size_t userDimIdx,
+                           PermissionsLayout& layout)
+{
+    layout.userDimIdx = userDimIdx;
+    layout.permDimIdx = 0;
+    layout.isRanges = false;
+    if (findDimension(permSchema.getDimensions(), permDimName, layout.permDimIdx))
+    {
+        return true;
+    }
+
+    bool hasLow = false, hasHigh = false;
+    for (auto const& attr : permSchema.getAttributes(true))
+    {
+        if (attr.getType() != TID_INT64)
+        {
+            continue;
+        }
+        if (attr.getName() == PERM_RANGE_LOW)
+        {
+            layout.lowAttr = attr;
+            hasLow = true;
+        }
+        else if (attr.getName() == PERM_RANGE_HIGH)
+        {
+            layout.highAttr = attr;
+            hasHigh = true;
+        }
+    }
+    layout.isRanges = hasLow && hasHigh;
+    return layout.isRanges;
+}
+
+ArrayPermissionSource::ArrayPermissionSource(ArrayDesc const& permSchema,
+                                             size_t userDimIdx,
+                                             size_t permDimIdx,
+                                             Coordinate userId,
+                                             std::shared_ptr<Query> const& query)
+    : _permSchema(permSchema)
+    , _userDimIdx(userDimIdx)
+    , _permDimIdx(permDimIdx)
+    , _userId(userId)
+    , _query(query)
+{}
+
+void ArrayPermissionSource::addTo(PermissionIntervals::Builder& builder)
+{
+    std::shared_ptr<Array> permArray(DBArray::createDBArray(_permSchema, _query));
+    LOG4CXX_DEBUG(logger, "secure_scan::permArray:" << permArray);
+
+    // Only the chunks holding the user row are read
+    DimensionDesc const& userDim = _permSchema.getDimensions()[_userDimIdx];
+    size_t nBulkChunks = 0, nCellChunks = 0;
+    shared_ptr<ConstArrayIterator> aiter = permArray->getConstIterator(_permSchema.getAttributes().firstDataAttribute());
+    while (!aiter->end())
+    {
+        Coordinate const userChunkStart = aiter->getPosition()[_userDimIdx];
+        if (_userId < userChunkStart || _userId >= userChunkStart + userDim.getChunkInterval())
+        {
+            ++(*aiter);
+            continue;
+        }
+
+        ConstChunk const& chunk = aiter->getChunk();
+        if (readPermissionSlice(chunk, _userDimIdx, _permDimIdx, _userId, builder))
+        {
+            nBulkChunks++;
+        }
+        else
+        {
+            // Visit the cells one by one
+            nCellChunks++;
+            shared_ptr<ConstChunkIterator> citer =
+                chunk.getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
+            while (!citer->end())
+            {
+                Coordinates const& permCoord = citer->getPosition();
+                if (permCoord[_userDimIdx] == _userId && citer->getItem().getBool())
+                {
+                    builder.add(permCoord[_permDimIdx], permCoord[_permDimIdx]);
+                }
+                ++(*citer);
+            }
+        }
+        ++(*aiter);
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::permission chunks read in bulk:" << nBulkChunks
+                  << " cell by cell:" << nCellChunks);
+}
+
+RangePermissionSource::RangePermissionSource(ArrayDesc const& permSchema,
+                                             PermissionsLayout const& layout,
+                                             Coordinate userId,
+                                             std::shared_ptr<Query> const& query)
+    : _permSchema(permSchema)
+    , _layout(layout)
+    , _userId(userId)
+    , _query(query)
+{}
+
+void RangePermissionSource::addTo(PermissionIntervals::Builder& builder)
+{
+    std::shared_ptr<Array> permArray(DBArray::createDBArray(_permSchema, _query));
+
+    // Only the chunks holding the user row are read, the low and high
+    // attributes side by side
+    DimensionDesc const& userDim = _permSchema.getDimensions()[_layout.userDimIdx];
+    size_t nGrants = 0;
+    shared_ptr<ConstArrayIterator> lowAiter = permArray->getConstIterator(_layout.lowAttr);
+    shared_ptr<ConstArrayIterator> highAiter = permArray->getConstIterator(_layout.highAttr);
+    while (!lowAiter->end())
+    {
+        Coordinates const& chunkPos = lowAiter->getPosition();
+        Coordinate const userChunkStart = chunkPos[_layout.userDimIdx];
+        if (_userId < userChunkStart || _userId >= userChunkStart + userDim.getChunkInterval())
+        {
+            ++(*lowAiter);
+            continue;
+        }
+        if (!highAiter->setPosition(chunkPos))
+        {
+            ++(*lowAiter);
+            continue;
+        }
+
+        shared_ptr<ConstChunkIterator> lowCiter =
+            lowAiter->getChunk().getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
+        shared_ptr<ConstChunkIterator> highCiter =
+            highAiter->getChunk().getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
+        while (!lowCiter->end() && !highCiter->end())
+        {
+            Value const& low = lowCiter->getItem();
+            Value const& high = highCiter->getItem();
+            if (lowCiter->getPosition()[_layout.userDimIdx] == _userId &&
+                !low.isNull() && !high.isNull() &&
+                low.getInt64() <= high.getInt64())
+            {
+                // Grants need not be sorted, the builder merges them
+                builder.add(low.getInt64(), high.getInt64());
+                nGrants++;
+            }
+            ++(*lowCiter);
+            ++(*highCiter);
+        }
+        ++(*lowAiter);
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::permission grants read:" << nGrants);
+}
+
+PermissionIntervals readLocalPermissions(ArrayDesc const& permSchema,
+                                         PermissionsLayout const& layout,
+                                         Coordinate userId,
+                                         std::shared_ptr<Query> const& query)
+{
+    PermissionIntervals localIntervals;
+    if (layout.isRanges)
+    {
+        localIntervals = RangePermissionSource(permSchema, layout, userId, query).read();
+    }
+    else
+    {
+        localIntervals = ArrayPermissionSource(permSchema,
+                                               layout.userDimIdx,
+                                               layout.permDimIdx,
+                                               userId,
+                                               query).read();
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::localIntervals:" << localIntervals.size());
+    return localIntervals;
+}
+
+std::vector<PermissionIntervals> readLocalPermissions(ArrayDesc const& permSchema,
+                                                      PermissionsLayout const& layout,
+                                                      std::vector<Coordinate> const& userIds,
+                                                      std::shared_ptr<Query> const& query)
+{
+    std::vector<PermissionIntervals::Builder> builders(userIds.size());
+    std::shared_ptr<Array> permArray(DBArray::createDBArray(permSchema, query));
+    DimensionDesc const& userDim = permSchema.getDimensions()[layout.userDimIdx];
+    AttributeDesc const& attr = layout.isRanges
+        ? layout.lowAttr
+        : permSchema.getAttributes().firstDataAttribute();
+    shared_ptr<ConstArrayIterator> aiter = permArray->getConstIterator(attr);
+    shared_ptr<ConstArrayIterator> highAiter;
+    if (layout.isRanges)
+    {
+        highAiter = permArray->getConstIterator(layout.highAttr);
+    }
+
+    // Only the chunks holding the row of one of the users are read, each
+    // once for all of them
+    for (; !aiter->end(); ++(*aiter))
+    {
+        Coordinates const& chunkPos = aiter->getPosition();
+        Coordinate const userChunkStart = chunkPos[layout.userDimIdx];
+        std::vector<Coordinate>::const_iterator const first =
+            std::lower_bound(userIds.begin(), userIds.end(), userChunkStart);
+        std::vector<Coordinate>::const_iterator const last =
+            std::lower_bound(first, userIds.end(), userChunkStart + userDim.getChunkInterval());
+        if (first == last)
+        {
+            continue;
+        }
+
+        ConstChunk const& chunk = aiter->getChunk();
+        std::vector<Coordinate> cellUserIds;
+        if (layout.isRanges)
+        {
+            if (!highAiter->setPosition(chunkPos))
+            {
+                continue;
+            }
+            shared_ptr<ConstChunkIterator> lowCiter =
+                chunk.getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
+            shared_ptr<ConstChunkIterator> highCiter =
+                highAiter->getChunk().getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
+            for (; !lowCiter->end() && !highCiter->end(); ++(*lowCiter), ++(*highCiter))
+            {
+                Coordinate const userId = lowCiter->getPosition()[layout.userDimIdx];
+                std::vector<Coordinate>::const_iterator const user =
+                    std::lower_bound(first, last, userId);
+                Value const& low = lowCiter->getItem();
+                Value const& high = highCiter->getItem();
+                if (user != last && *user == userId &&
+                    !low.isNull() && !high.isNull() &&
+                    low.getInt64() <= high.getInt64())
+                {
+                    builders[user - userIds.begin()].add(low.getInt64(), high.getInt64());
+                }
+            }
+            continue;
+        }
+
+        // The users whose slice cannot be read in bulk are read cell by
+        // cell, in one pass over the chunk
+        for (std::vector<Coordinate>::const_iterator user = first; user != last; ++user)
+        {
+            if (!readPermissionSlice(chunk,
+                                     layout.userDimIdx,
+                                     layout.permDimIdx,
+                                     *user,
+                                     builders[user - userIds.begin()]))
+            {
+                cellUserIds.push_back(*user);
+            }
+        }
+        if (cellUserIds.empty())
+        {
+            continue;
+        }
+        shared_ptr<ConstChunkIterator> citer =
+            chunk.getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
+        for (; !citer->end(); ++(*citer))
+        {
+            Coordinates const& permCoord = citer->getPosition();
+            Coordinate const userId = permCoord[layout.userDimIdx];
+            if (std::binary_search(cellUserIds.begin(), cellUserIds.end(), userId) &&
+                citer->getItem().getBool())
+            {
+                size_t const u = std::lower_bound(first, last, userId) - userIds.begin();
+                builders[u].add(permCoord[layout.permDimIdx], permCoord[layout.permDimIdx]);
+            }
+        }
+    }
+
+    std::vector<PermissionIntervals> result(builders.size());
+    for (size_t u = 0; u < builders.size(); u++)
+    {
+        result[u] = builders[u].finish();
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::localIntervals of users:" << userIds.size());
+    return result;
+}
+
+/**
+ * Send a buffer to every other instance of the query and receive
+ * theirs.
+ * @return the buffers of all instances, indexed by instance ID.
+ */
+static std::vector<std::shared_ptr<SharedBuffer> > allGather(
+    std::shared_ptr<SharedBuffer> const& buf,
+    std::shared_ptr<Query>& query)
+{
+    size_t const nInstances = query->getInstancesCount();
+    InstanceID const myId = query->getInstanceID();
+
+    for (InstanceID i = 0; i < nInstances; i++)
+    {
+        if (i != myId)
+        {
+            BufSend(i, buf, query);
+        }
+    }
+
+    std::vector<std::shared_ptr<SharedBuffer> > result(nInstances);
+    for (InstanceID i = 0; i < nInstances; i++)
+    {
+        result[i] = (i == myId) ? buf : BufReceive(i, query);
+    }
+    return result;
+}
+
+PermissionIntervals exchangePermissions(PermissionIntervals const& localIntervals,
+                                        std::shared_ptr<Query>& query)
+{
+    std::shared_ptr<SharedBuffer> buf(new MemoryBuffer(NULL, localIntervals.getSerializedSize()));
+    localIntervals.serialize(buf->getWriteData());
+    std::vector<std::shared_ptr<SharedBuffer> > bufs = allGather(buf, query);
+
+    // Each instance contributes one sorted run
+    PermissionIntervals::Builder builder;
+    for (size_t i = 0; i < bufs.size(); i++)
+    {
+        builder.add(PermissionIntervals::deserialize(bufs[i]->getConstData(),
+                                                     bufs[i]->getSize()));
+    }
+    return builder.finish();
+}
+
+std::vector<PermissionIntervals> exchangePermissions(
+    std::vector<PermissionIntervals> const& localIntervals,
+    std::shared_ptr<Query>& query)
+{
+    size_t size = 0;
+    for (size_t u = 0; u < localIntervals.size(); u++)
+    {
+        size += localIntervals[u].getSerializedSize();
+    }
+    std::shared_ptr<SharedBuffer> buf(new MemoryBuffer(NULL, size));
+    char* dst = static_cast<char*>(buf->getWriteData());
+    for (size_t u = 0; u < localIntervals.size(); u++)
+    {
+        localIntervals[u].serialize(dst);
+        dst += localIntervals[u].getSerializedSize();
+    }
+    std::vector<std::shared_ptr<SharedBuffer> > bufs = allGather(buf, query);
+
+    // The intervals of each user follow one another in each buffer
+    std::vector<PermissionIntervals::Builder> builders(localIntervals.size());
+    for (size_t i = 0; i < bufs.size(); i++)
+    {
+        char const* src = static_cast<char const*>(bufs[i]->getConstData());
+        char const* const srcEnd = src + bufs[i]->getSize();
+        for (size_t u = 0; u < builders.size(); u++)
+        {
+            uint64_t count = 0;
+            SCIDB_ASSERT(src + sizeof(count) <= srcEnd);
+            memcpy(&count, src, sizeof(count));
+            size_t const itemSize = sizeof(count) + count * 2 * sizeof(Coordinate);
+            SCIDB_ASSERT(src + itemSize <= srcEnd);
+            builders[u].add(PermissionIntervals::deserialize(src, itemSize));
+            src += itemSize;
+        }
+    }
+
+    std::vector<PermissionIntervals> result(builders.size());
+    for (size_t u = 0; u < builders.size(); u++)
+    {
+        result[u] = builders[u].finish();
+    }
+    return result;
+}
+
+std::vector<std::string> getPermDimNames()
+{
+    std::vector<std::string> names(1, PERM_DIM);
+    std::vector<std::string> const extraNames = PERM_EXTRA_DIMS;
+    names.insert(names.end(), extraNames.begin(), extraNames.end());
+    return names;
+}
+
+std::string getPermArrayName(std::string const& permDimName)
+{
+    return permDimName == PERM_DIM ? PERM_ARRAY : permDimName;
+}
+
+/**
+ * Take a read lock on an array of PERM_NS.
+ */
+static void lockArray(std::shared_ptr<Query> const& query, std::string const& arrayName)
+{
+    auto lock = LockDesc::create(PERM_NS,
+                                 arrayName,
+                                 query->getTxn(),
+                                 LockDesc::COORD,
+                                 LockDesc::RD);
+    std::shared_ptr<LockDesc> resLock = query->getTxn().requestLock(lock);
+    SCIDB_ASSERT(resLock);
+    SCIDB_ASSERT(resLock->getLockMode() >= LockDesc::RD);
+}
+
+/**
+ * @return the last version of an array of PERM_NS, 0 if it does not
+ * exist.
+ */
+static VersionID findLastVersion(std::shared_ptr<Query> const& query,
+                                 std::string const& arrayName)
+{
+    ArrayDesc schema;
+    SystemCatalog::GetArrayDescArgs args;
+    args.nsName = PERM_NS;
+    args.arrayName = arrayName;
+    args.versionId = LAST_VERSION;
+    args.throwIfNotFound = false;
+    args.result = &schema;
+    if (!CatalogMemo::getInstance()->getArrayDesc(query, args))
+    {
+        return 0;
+    }
+    return schema.getVersionId();
+}
+
+void lockPermissionsArrays(std::shared_ptr<Query> const& query)
+{
+    std::vector<std::string> const permDimNames = getPermDimNames();
+    for (size_t d = 0; d < permDimNames.size(); d++)
+    {
+        std::string const permArrayName = getPermArrayName(permDimNames[d]);
+        lockArray(query, permArrayName);
+        lockArray(query, permArrayName + ROLE_ARRAY_SUFFIX);
+    }
+    lockArray(query, ROLE_MEMBERS_ARRAY);
+}
+
+std::vector<PinnedPermissions> pinPermissions(std::shared_ptr<Query> const& query)
+{
+    std::vector<PinnedPermissions> pinned;
+    std::vector<std::string> const permDimNames = getPermDimNames();
+    for (size_t d = 0; d < permDimNames.size(); d++)
+    {
+        ArrayDesc permSchema;
+        if (findPermissionsArray(query, permDimNames[d], false, NULL, permSchema))
+        {
+            PinnedPermissions item;
+            item.dimName = permDimNames[d];
+            item.permUAId = permSchema.getUAId();
+            item.permVersion = permSchema.getVersionId();
+            item.grantsVersion = findLastVersion(query,
+                                                 getPermArrayName(item.dimName) + ROLE_ARRAY_SUFFIX);
+            item.membersVersion = item.grantsVersion ?
+                findLastVersion(query, ROLE_MEMBERS_ARRAY) : 0;
+            if (item.membersVersion == 0)
+            {
+                item.grantsVersion = 0;
+            }
+            pinned.push_back(item);
+        }
+    }
+    return pinned;
+}
+
+PinnedPermissions const* findPinnedPermissions(std::vector<PinnedPermissions> const& pinned,
+                                               std::string const& dimName)
+{
+    for (size_t i = 0; i < pinned.size(); i++)
+    {
+        if (pinned[i].dimName == dimName)
+        {
+            return &pinned[i];
+        }
+    }
+    return NULL;
+}
+
+bool findPermissionsArray(std::shared_ptr<Query> const& query,
+                          std::string const& permDimName,
+                          bool isRequired,
+                          std::vector<PinnedPermissions> const* pinned,
+                          ArrayDesc& permSchema)
+{
+    SystemCatalog::GetArrayDescArgs args;
+    args.nsName = PERM_NS;
+    args.arrayName = getPermArrayName(permDimName);
+    args.versionId = LAST_VERSION;
+    args.throwIfNotFound = isRequired;
+    args.result = &permSchema;
+    if (pinned)
+    {
+        PinnedPermissions const* item = findPinnedPermissions(*pinned, permDimName);
+        if (item)
+        {
+            args.versionId = item->permVersion;
+            args.throwIfNotFound = true;
+        }
+        else if (!isRequired)
+        {
+            return false;
+        }
+        // A required array that was not pinned does not exist, the
+        // lookup of its last version reports it
+    }
+    if (!CatalogMemo::getInstance()->getArrayDesc(query, args))
+    {
+        return false;
+    }
+    permSchema.setNamespaceName(args.nsName);
+    return true;
+}
+
+/**
+ * Write intervals to a cookie, their count first.
+ */
+static void writeIntervals(std::ostream& out, PermissionIntervals const& intervals)
+{
+    std::vector<PermissionIntervals::Interval> const& items = intervals.intervals();
+    out << ' ' << items.size();
+    for (size_t j = 0; j < items.size(); j++)
+    {
+        out << ' ' << items[j].first << ' ' << items[j].second;
+    }
+}
+
+/**
+ * Read intervals written by writeIntervals.
+ * @return false if the cookie is truncated.
+ */
+static bool readIntervals(std::istream& in, PermissionIntervals& intervals)
+{
+    size_t count = 0;
+    if (!(in >> count))
+    {
+        return false;
+    }
+    for (size_t j = 0; j < count; j++)
+    {
+        Coordinate low, high;
+        if (!(in >> low >> high))
+        {
+            return false;
+        }
+        intervals.append(low, high);
+    }
+    return true;
+}
+
+std::string makePermissionsCookie(std::vector<PinnedPermissions> const& pinned,
+                                  std::vector<ResolvedPermissions> const& resolved,
+                                  std::vector<ResolvedRoles> const& roles)
+{
+    std::ostringstream out;
+    out << RESOLVED_PERM << ' ' << pinned.size();
+    for (size_t i = 0; i < pinned.size(); i++)
+    {
+        out << ' ' << pinned[i].dimName
+            << ' ' << pinned[i].permUAId
+            << ' ' << pinned[i].permVersion
+            << ' ' << pinned[i].grantsVersion
+            << ' ' << pinned[i].membersVersion;
+    }
+    out << ' ' << resolved.size();
+    for (size_t i = 0; i < resolved.size(); i++)
+    {
+        out << ' ' << resolved[i].dimName
+            << ' ' << resolved[i].permUAId
+            << ' ' << resolved[i].permVersion;
+        writeIntervals(out, resolved[i].intervals);
+    }
+    out << ' ' << roles.size();
+    for (size_t i = 0; i < roles.size(); i++)
+    {
+        out << ' ' << roles[i].dimName;
+        writeIntervals(out, roles[i].intervals);
+        out << ' ' << roles[i].missingIds.size();
+        for (size_t j = 0; j < roles[i].missingIds.size(); j++)
+        {
+            out << ' ' << roles[i].missingIds[j];
+        }
+    }
+    if (out.tellp() > static_cast<std::streamoff>(PERM_COOKIE_MAX_BYTES) &&
+        !(resolved.empty() && roles.empty()))
+    {
+        // Too many intervals to ship to every worker
+        LOG4CXX_DEBUG(logger, "secure_scan::cookie too large:" << out.tellp());
+        return makePermissionsCookie(pinned,
+                                     std::vector<ResolvedPermissions>(),
+                                     std::vector<ResolvedRoles>());
+    }
+    return out.str();
+}
+
+bool parsePermissionsCookie(std::string const& cookie,
+                            std::vector<PinnedPermissions>& pinned,
+                            std::vector<ResolvedPermissions>& resolved,
+                            std::vector<ResolvedRoles>& roles)
+{
+    std::istringstream in(cookie);
+    std::string tag;
+    size_t nPinned = 0;
+    in >> tag;
+    if (tag != RESOLVED_PERM || !(in >> nPinned))
+    {
+        return false;
+    }
+
+    std::vector<PinnedPermissions> pins(nPinned);
+    for (size_t i = 0; i < nPinned; i++)
+    {
+        if (!(in >> pins[i].dimName >> pins[i].permUAId >> pins[i].permVersion
+              >> pins[i].grantsVersion >> pins[i].membersVersion))
+        {
+            return false;
+        }
+    }
+
+    size_t nDims = 0;
+    if (!(in >> nDims))
+    {
+        return false;
+    }
+    std::vector<ResolvedPermissions> result(nDims);
+    for (size_t i = 0; i < nDims; i++)
+    {
+        ResolvedPermissions& item = result[i];
+        if (!(in >> item.dimName >> item.permUAId >> item.permVersion) ||
+            !readIntervals(in, item.intervals))
+        {
+            return false;
+        }
+    }
+
+    size_t nRoles = 0;
+    if (!(in >> nRoles))
+    {
+        return false;
+    }
+    std::vector<ResolvedRoles> resultRoles(nRoles);
+    for (size_t i = 0; i < nRoles; i++)
+    {
+        ResolvedRoles& item = resultRoles[i];
+        size_t nMissing = 0;
+        if (!(in >> item.dimName) || !readIntervals(in, item.intervals) || !(in >> nMissing))
+        {
+            return false;
+        }
+        item.missingIds.resize(nMissing);
+        for (size_t j = 0; j < nMissing; j++)
+        {
+            if (!(in >> item.missingIds[j]))
+            {
+                return false;
+            }
+        }
+    }
+    pinned.swap(pins);
+    resolved.swap(result);
+    roles.swap(resultRoles);
+    return true;
+}
+
+ResolvedPermissions const* findResolvedPermissions(std::vector<ResolvedPermissions> const& resolved,
+                                                   std::string const& dimName,
+                                                   ArrayUAID permUAId,
+                                                   VersionID permVersion)
+{
+    for (size_t i = 0; i < resolved.size(); i++)
+    {
+        if (resolved[i].dimName == dimName &&
+            resolved[i].permUAId == permUAId &&
+            resolved[i].permVersion == permVersion)
+        {
+            return &resolved[i];
+        }
+    }
+    return NULL;
+}
+
+ResolvedRoles const* findResolvedRoles(std::vector<ResolvedRoles> const& roles,
+                                       std::string const& dimName)
+{
+    for (size_t i = 0; i < roles.size(); i++)
+    {
+        if (roles[i].dimName == dimName)
+        {
+            return &roles[i];
+        }
+    }
+    return NULL;
+}
+
+} //namespace scidb
@@ -0,0 +1,288 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file Permissions.h
+ *
+ * @brief Reading the permissions of a user from the permissions array.
+ *
+ * None of these functions validate the permissions array, the caller
+ * is expected to do so and to report errors to the user.
+ */
+
+#ifndef PERMISSIONS_H_
+#define PERMISSIONS_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <array/Metadata.h>
+#include <query/Query.h>
+
+#include "PermissionIntervals.h"
+#include "PermissionSource.h"
+
+namespace scidb
+{
+
+/**
+ * Find a dimension by name.
+ * @param[out] idx set to the index of the dimension if found.
+ * @return true if the dimension was found.
+ */
+bool findDimension(Dimensions const& dims, std::string const& name, size_t& idx);
+
+/**
+ * How a permissions array stores the permissions along its permission
+ * dimension: either one bool cell per user and permitted coordinate,
+ * or one cell per grant, holding the first and last coordinates of a
+ * range of permitted coordinates.
+ */
+struct PermissionsLayout
+{
+    size_t        userDimIdx;
+    bool          isRanges;
+    size_t        permDimIdx;
+    AttributeDesc lowAttr;
+    AttributeDesc highAttr;
+};
+
+/**
+ * Find the layout of a permissions array, knowing its user dimension.
+ * The cell layout is used if the array has the permission dimension,
+ * the range layout if it has int64 attributes PERM_RANGE_LOW and
+ * PERM_RANGE_HIGH.
+ * @return false if the array has neither layout.
+ */
+bool findPermissionsLayout(ArrayDesc const& permSchema,
+                           std::string const& permDimName,
+                           size_t userDimIdx,
+                           PermissionsLayout& layout);
+
+/**
+ * The part of the user row of a permissions array stored on this
+ * instance.
+ */
+class ArrayPermissionSource : public PermissionSource
+{
+public:
+    ArrayPermissionSource(ArrayDesc const& permSchema,
+                          size_t userDimIdx,
+                          size_t permDimIdx,
+                          Coordinate userId,
+                          std::shared_ptr<Query> const& query);
+
+    void addTo(PermissionIntervals::Builder& builder) override;
+
+private:
+    ArrayDesc              _permSchema;
+    size_t                 _userDimIdx;
+    size_t                 _permDimIdx;
+    Coordinate             _userId;
+    std::shared_ptr<Query> _query;
+};
+
+/**
+ * The ranges granted to the user in a permissions array with the range
+ * layout, stored on this instance. The cost of reading them depends on
+ * the number of grants, not on the number of permitted coordinates.
+ */
+class RangePermissionSource : public PermissionSource
+{
+public:
+    RangePermissionSource(ArrayDesc const& permSchema,
+                          PermissionsLayout const& layout,
+                          Coordinate userId,
+                          std::shared_ptr<Query> const& query);
+
+    void addTo(PermissionIntervals::Builder& builder) override;
+
+private:
+    ArrayDesc              _permSchema;
+    PermissionsLayout      _layout;
+    Coordinate             _userId;
+    std::shared_ptr<Query> _query;
+};
+
+/**
+ * Collapse the part of the user row stored on this instance into
+ * intervals along the permission dimension.
+ */
+PermissionIntervals readLocalPermissions(ArrayDesc const& permSchema,
+                                         PermissionsLayout const& layout,
+                                         Coordinate userId,
+                                         std::shared_ptr<Query> const& query);
+
+/**
+ * Collapse the parts of the rows of several users stored on this
+ * instance, reading the permissions array once.
+ * @param userIds the users, sorted and distinct.
+ * @return the local intervals of each user, in the same order.
+ */
+std::vector<PermissionIntervals> readLocalPermissions(ArrayDesc const& permSchema,
+                                                      PermissionsLayout const& layout,
+                                                      std::vector<Coordinate> const& userIds,
+                                                      std::shared_ptr<Query> const& query);
+
+/**
+ * Send the local intervals to every other instance of the query and
+ * merge theirs. Must be called on all instances of the query.
+ */
+PermissionIntervals exchangePermissions(PermissionIntervals const& localIntervals,
+                                        std::shared_ptr<Query>& query);
+
+/**
+ * Exchange the local intervals of several users in one round.
+ * @return the merged intervals of each user, in the same order.
+ */
+std::vector<PermissionIntervals> exchangePermissions(
+    std::vector<PermissionIntervals> const& localIntervals,
+    std::shared_ptr<Query>& query);
+
+/**
+ * The permissions of the user along one permission dimension, along
+ * with the UAId and version of the permissions array they were read
+ * from.
+ */
+struct ResolvedPermissions
+{
+    std::string         dimName;
+    ArrayUAID           permUAId;
+    VersionID           permVersion;
+    PermissionIntervals intervals;
+};
+
+/**
+ * The roles of the user along one permission dimension, resolved by the
+ * coordinator from its cache or from replicated role arrays: the union
+ * of the permissions of the roles it found, and the IDs of the roles
+ * whose permissions the workers still read.
+ */
+struct ResolvedRoles
+{
+    std::string             dimName;
+    PermissionIntervals     intervals;
+    std::vector<Coordinate> missingIds;
+};
+
+/**
+ * The version of the permissions array of a permission dimension and of
+ * its role arrays, looked up once by the coordinator and shipped to the
+ * workers, so that every instance reads the same versions and all of
+ * them take part in the same exchanges.
+ */
+struct PinnedPermissions
+{
+    std::string dimName;
+    ArrayUAID   permUAId;
+    VersionID   permVersion;
+    VersionID   grantsVersion;  // role permissions array, 0 if absent
+    VersionID   membersVersion; // role members array, 0 if absent
+};
+
+/**
+ * @return the names of the permission dimensions, PERM_DIM first.
+ */
+std::vector<std::string> getPermDimNames();
+
+/**
+ * @return the name of the permissions array of a permission dimension.
+ */
+std::string getPermArrayName(std::string const& permDimName);
+
+/**
+ * Take a read lock on the permissions array and the role arrays of
+ * every permission dimension, whether they exist or not, so that none
+ * of them is created or removed during the query.
+ */
+void lockPermissionsArrays(std::shared_ptr<Query> const& query);
+
+/**
+ * Pin the last version of the permissions array of every permission
+ * dimension that has one, and of its role arrays if both exist. Called
+ * on the coordinator, under the locks of lockPermissionsArrays.
+ */
+std::vector<PinnedPermissions> pinPermissions(std::shared_ptr<Query> const& query);
+
+/**
+ * @return the pinned version of the permissions array of a dimension,
+ * null if there is none.
+ */
+PinnedPermissions const* findPinnedPermissions(std::vector<PinnedPermissions> const& pinned,
+                                               std::string const& dimName);
+
+/**
+ * Look up the permissions array of a permission dimension, at its
+ * pinned version if the coordinator pinned the versions, otherwise at
+ * its last version. The array is not validated.
+ * @param pinned the pinned versions, null if there are none.
+ * @param isRequired report the array as not found instead of returning
+ *                   false.
+ * @return false if the array does not exist, or was not pinned.
+ */
+bool findPermissionsArray(std::shared_ptr<Query> const& query,
+                          std::string const& permDimName,
+                          bool isRequired,
+                          std::vector<PinnedPermissions> const* pinned,
+                          ArrayDesc& permSchema);
+
+/**
+ * The control cookie used by the coordinator to ship the pinned
+ * versions of the permissions arrays, and the resolved permissions and
+ * roles of the user, if any, to the workers. The resolved permissions
+ * and roles are left out if the cookie would exceed
+ * PERM_COOKIE_MAX_BYTES.
+ */
+std::string makePermissionsCookie(std::vector<PinnedPermissions> const& pinned,
+                                  std::vector<ResolvedPermissions> const& resolved,
+                                  std::vector<ResolvedRoles> const& roles);
+
+/**
+ * @return false if the cookie does not carry pinned versions.
+ */
+bool parsePermissionsCookie(std::string const& cookie,
+                            std::vector<PinnedPermissions>& pinned,
+                            std::vector<ResolvedPermissions>& resolved,
+                            std::vector<ResolvedRoles>& roles);
+
+/**
+ * @return the resolved permissions of a dimension for a version of its
+ * permissions array, null if there are none.
+ */
+ResolvedPermissions const* findResolvedPermissions(std::vector<ResolvedPermissions> const& resolved,
+                                                   std::string const& dimName,
+                                                   ArrayUAID permUAId,
+                                                   VersionID permVersion);
+
+/**
+ * @return the resolved roles of a dimension, null if there are none.
+ */
+ResolvedRoles const* findResolvedRoles(std::vector<ResolvedRoles> const& roles,
+                                       std::string const& dimName);
+
+} //namespace scidb
+
+#endif /* PERMISSIONS_H_ */
@@ -0,0 +1,226 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionsBenchmark.cpp
+ *
+ * @brief Microbenchmarks of the permission kernel, run without any
+ * SciDB instance: make microbench && ./permissions_benchmark
+ *
+ * The grants of a user are synthetic: BENCH_DATASETS coordinates, of
+ * which one in every stride is the start of a run of permitted
+ * coordinates. Each benchmark takes the number of grants and the run
+ * length as arguments, a run length of 1 being the most fragmented.
+ */
+
+#include <algorithm>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include "ChunkPlan.h"
+#include "PermissionBitmap.h"
+#include "PermissionIntervals.h"
+#include "PermissionSource.h"
+
+using namespace std;
+using namespace scidb;
+
+namespace
+{
+
+const Coordinate BENCH_DATASETS = 1000000;
+const int64_t    BENCH_CHUNK    = 10000;
+
+/**
+ * Streams the permitted coordinates of a user cell by cell, one chunk
+ * of the permission dimension at a time, like the cell iterator of the
+ * permissions array.
+ */
+class MockPermissionSource : public PermissionSource
+{
+public:
+    /**
+     * @param shuffled visit the chunks in random order instead of in
+     *                 order along the permission dimension.
+     */
+    MockPermissionSource(int64_t grants, int64_t run, bool shuffled)
+        : _stride(BENCH_DATASETS * run / grants),
+          _run(run)
+    {
+        for (Coordinate c = 0; c < BENCH_DATASETS; c += BENCH_CHUNK)
+        {
+            _chunks.push_back(c);
+        }
+        if (shuffled)
+        {
+            std::mt19937 rng(42);
+            std::shuffle(_chunks.begin(), _chunks.end(), rng);
+        }
+    }
+
+    bool isPermitted(Coordinate coord) const
+    {
+        return coord % _stride < _run;
+    }
+
+    void addTo(PermissionIntervals::Builder& builder) override
+    {
+        for (size_t i = 0; i < _chunks.size(); i++)
+        {
+            Coordinate const end = std::min(_chunks[i] + BENCH_CHUNK, BENCH_DATASETS);
+            for (Coordinate c = _chunks[i]; c < end; c++)
+            {
+                if (isPermitted(c))
+                {
+                    builder.add(c, c);
+                }
+            }
+        }
+    }
+
+private:
+    Coordinate              _stride;
+    Coordinate              _run;
+    std::vector<Coordinate> _chunks;
+};
+
+Dimensions makeDimensions()
+{
+    Dimensions dims;
+    dims.push_back(DimensionDesc("dataset_id", 0, BENCH_DATASETS - 1, BENCH_CHUNK, 0));
+    return dims;
+}
+
+void BM_BuildIntervals(benchmark::State& state)
+{
+    MockPermissionSource source(state.range(0), state.range(1), state.range(2) != 0);
+    size_t nIntervals = 0;
+    for (auto _ : state)
+    {
+        PermissionIntervals intervals = source.read();
+        nIntervals = intervals.size();
+        benchmark::DoNotOptimize(nIntervals);
+    }
+    state.counters["intervals"] = nIntervals;
+    state.SetItemsProcessed(state.iterations() * BENCH_DATASETS);
+}
+
+void BM_BuildPlan(benchmark::State& state)
+{
+    MockPermissionSource source(state.range(0), state.range(1), false);
+    PermissionIntervals const intervals = source.read();
+    Dimensions const dims = makeDimensions();
+    size_t nSlabs = 0;
+    for (auto _ : state)
+    {
+        ChunkPlan::Dimension dimension(intervals, dims, 0);
+        nSlabs = dimension.getSlabs().size();
+        benchmark::DoNotOptimize(nSlabs);
+    }
+    state.counters["slabs"] = nSlabs;
+    state.counters["bitmap"] = PermissionBitmap::isFragmented(intervals.size(),
+                                                              intervals.cardinality());
+}
+
+/**
+ * Build the mask of every chunk and test every cell against it, as a
+ * masked chunk does.
+ */
+void BM_MaskMembership(benchmark::State& state)
+{
+    MockPermissionSource source(state.range(0), state.range(1), false);
+    ChunkPlan::Dimension const dimension(source.read(), makeDimensions(), 0);
+    std::vector<bool> mask;
+    for (auto _ : state)
+    {
+        uint64_t permitted = 0;
+        for (Coordinate c = 0; c < BENCH_DATASETS; c += BENCH_CHUNK)
+        {
+            dimension.buildMask(c, c + BENCH_CHUNK - 1, mask);
+            for (size_t i = 0; i < mask.size(); i++)
+            {
+                permitted += mask[i];
+            }
+        }
+        benchmark::DoNotOptimize(permitted);
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_DATASETS);
+}
+
+/**
+ * Test every cell against the bitmap, as a masked chunk does when the
+ * permissions are fragmented.
+ */
+void BM_BitmapMembership(benchmark::State& state)
+{
+    MockPermissionSource source(state.range(0), state.range(1), false);
+    PermissionBitmap const bitmap(source.read());
+    for (auto _ : state)
+    {
+        uint64_t permitted = 0;
+        for (Coordinate c = 0; c < BENCH_DATASETS; c++)
+        {
+            permitted += bitmap.contains(c);
+        }
+        benchmark::DoNotOptimize(permitted);
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_DATASETS);
+}
+
+/**
+ * Grants, run length and, for BM_BuildIntervals, chunk order.
+ */
+void grantDistributions(benchmark::internal::Benchmark* bench)
+{
+    int64_t const grants[] = { 1000, 100000 };
+    int64_t const runs[] = { 1, 10, 1000 };
+    for (size_t g = 0; g < sizeof(grants) / sizeof(grants[0]); g++)
+    {
+        for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++)
+        {
+            if (grants[g] % runs[r] == 0)
+            {
+                bench->Args({ grants[g], runs[r], 0 });
+            }
+        }
+    }
+}
+
+void shuffledDistributions(benchmark::internal::Benchmark* bench)
+{
+    grantDistributions(bench);
+    bench->Args({ 100000, 1, 1 });
+    bench->Args({ 100000, 10, 1 });
+}
+
+}
+
+BENCHMARK(BM_BuildIntervals)->Apply(shuffledDistributions);
+BENCHMARK(BM_BuildPlan)->Apply(grantDistributions);
+BENCHMARK(BM_MaskMembership)->Apply(grantDistributions);
+BENCHMARK(BM_BitmapMembership)->Apply(grantDistributions);
+
+BENCHMARK_MAIN();
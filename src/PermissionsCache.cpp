@@ -0,0 +1,140 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <log4cxx/logger.h>
+
+#include "settings.h"
+#include "PermissionsCache.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+PermissionsCache* PermissionsCache::getInstance()
+{
+    static PermissionsCache instance;
+    return &instance;
+}
+
+bool PermissionsCache::get(Coordinate userId,
+                           ArrayUAID permUAId,
+                           VersionID permVersion,
+                           PermissionIntervals& intervals)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Entries::iterator it = _entries.find(Key(permUAId, userId));
+    if (it == _entries.end())
+    {
+        return false;
+    }
+    if (it->second.version != permVersion)
+    {
+        // A new version was stored since this entry was filled, or the
+        // query reads an older version than the cached one
+        if (it->second.version < permVersion)
+        {
+            LOG4CXX_DEBUG(logger, "secure_scan::cache stale entry for user:" << userId);
+            erase(it);
+        }
+        return false;
+    }
+    _uses.splice(_uses.begin(), _uses, it->second.use);
+    intervals = it->second.intervals;
+    LOG4CXX_DEBUG(logger, "secure_scan::cache hit for user:" << userId);
+    return true;
+}
+
+void PermissionsCache::put(Coordinate userId,
+                           ArrayUAID permUAId,
+                           VersionID permVersion,
+                           PermissionIntervals const& intervals)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // All the entries of an array have the same version: ignore an
+    // older version, and drop the entries of an older version
+    Entries::iterator it = _entries.lower_bound(Key(permUAId, CoordinateBounds::getMin()));
+    if (it != _entries.end() && it->first.first == permUAId)
+    {
+        if (it->second.version > permVersion)
+        {
+            return;
+        }
+        if (it->second.version < permVersion)
+        {
+            while (it != _entries.end() && it->first.first == permUAId)
+            {
+                Entries::iterator next = it;
+                ++next;
+                erase(it);
+                it = next;
+            }
+        }
+    }
+
+    Key const key(permUAId, userId);
+    it = _entries.find(key);
+    if (it != _entries.end())
+    {
+        erase(it);
+    }
+    size_t const cost = getCost(intervals);
+    if (cost > PERM_CACHE_MAX_INTERVALS)
+    {
+        LOG4CXX_DEBUG(logger, "secure_scan::cache too many intervals for user:" << userId);
+        return;
+    }
+    while (_nIntervals + cost > PERM_CACHE_MAX_INTERVALS)
+    {
+        evictOne();
+    }
+    _uses.push_front(key);
+    it = _entries.insert(make_pair(key, Entry())).first;
+    Entry& entry = it->second;
+    entry.version = permVersion;
+    entry.intervals = intervals;
+    entry.use = _uses.begin();
+    _nIntervals += cost;
+}
+
+void PermissionsCache::erase(Entries::iterator it)
+{
+    _nIntervals -= getCost(it->second.intervals);
+    _uses.erase(it->second.use);
+    _entries.erase(it);
+}
+
+void PermissionsCache::evictOne()
+{
+    SCIDB_ASSERT(!_entries.empty());
+    Entries::iterator victim = _entries.find(_uses.back());
+    SCIDB_ASSERT(victim != _entries.end());
+    erase(victim);
+}
+
+} //namespace scidb
@@ -0,0 +1,128 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionsCache.h
+ *
+ * @brief Per-instance cache of the collapsed permission intervals of
+ * each user.
+ *
+ * Entries are keyed by user ID and the UAId of the permissions array
+ * they were read from, or by role ID for the role arrays of
+ * RolePermissions.h, and tagged with its version. A lookup against a
+ * newer version drops the stale entry, and storing an entry for a newer
+ * version drops every entry of the older versions of that array, so a
+ * new version of a permissions array invalidates the cache without any
+ * hook in the store path. Storing an entry for an older version than
+ * the cached one is ignored, so all the entries of an array have the
+ * same version.
+ *
+ * The cache is bounded by the number of intervals it holds, since the
+ * intervals of a user may be few or many. The entries are kept in a
+ * list in order of use next to the map, so that a lookup, a store and
+ * an eviction take logarithmic time.
+ */
+
+#ifndef PERMISSIONS_CACHE_H_
+#define PERMISSIONS_CACHE_H_
+
+#include <list>
+#include <map>
+#include <mutex>
+
+#include <array/Metadata.h>
+
+#include "PermissionIntervals.h"
+
+namespace scidb
+{
+
+class PermissionsCache
+{
+public:
+    static PermissionsCache* getInstance();
+
+    /**
+     * Look up the intervals of a user.
+     * @param[out] intervals set to the cached intervals on a hit.
+     * @return true on a hit.
+     */
+    bool get(Coordinate userId,
+             ArrayUAID permUAId,
+             VersionID permVersion,
+             PermissionIntervals& intervals);
+
+    void put(Coordinate userId,
+             ArrayUAID permUAId,
+             VersionID permVersion,
+             PermissionIntervals const& intervals);
+
+private:
+    PermissionsCache()
+        : _nIntervals(0)
+    {}
+
+    // Keyed by array first, so that the entries of an array are adjacent
+    typedef std::pair<ArrayUAID, Coordinate> Key;
+    typedef std::list<Key> UseList;
+
+    struct Entry
+    {
+        VersionID           version;
+        PermissionIntervals intervals;
+        UseList::iterator   use;
+    };
+
+    typedef std::map<Key, Entry> Entries;
+
+    /**
+     * Drop an entry and its position in the use list.
+     * @pre _mutex is held.
+     */
+    void erase(Entries::iterator it);
+
+    /**
+     * Drop the least recently used entry.
+     * @pre _mutex is held.
+     */
+    void evictOne();
+
+    /**
+     * @return the share of the budget taken by the intervals of an entry.
+     */
+    static size_t getCost(PermissionIntervals const& intervals)
+    {
+        return intervals.size() + 1;
+    }
+
+    std::mutex _mutex;
+    Entries    _entries;
+    UseList    _uses;       // most recently used first
+    size_t     _nIntervals; // cost of all the entries
+};
+
+} //namespace scidb
+
+#endif /* PERMISSIONS_CACHE_H_ */
@@ -0,0 +1,113 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <functional>
+
+#include <log4cxx/logger.h>
+
+#include "PermissionsContext.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+PermissionsContext* PermissionsContext::getInstance()
+{
+    static PermissionsContext instance;
+    return &instance;
+}
+
+bool PermissionsContext::get(std::shared_ptr<Query> const& query,
+                             std::string const& dimName,
+                             ArrayUAID permUAId,
+                             VersionID permVersion,
+                             PermissionIntervals& intervals)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Queries::const_iterator it = _queries.find(query->getQueryID());
+    if (it == _queries.end())
+    {
+        return false;
+    }
+    ResolvedPermissions const* item = findResolvedPermissions(it->second,
+                                                              dimName,
+                                                              permUAId,
+                                                              permVersion);
+    if (!item)
+    {
+        return false;
+    }
+    intervals = item->intervals;
+    LOG4CXX_DEBUG(logger, "secure_scan::context hit for query:" << query->getQueryID());
+    return true;
+}
+
+void PermissionsContext::put(std::shared_ptr<Query> const& query,
+                             std::string const& dimName,
+                             ArrayUAID permUAId,
+                             VersionID permVersion,
+                             PermissionIntervals const& intervals)
+{
+    QueryID const queryId = query->getQueryID();
+    bool isNewQuery = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        Queries::iterator it = _queries.find(queryId);
+        if (it == _queries.end())
+        {
+            it = _queries.insert(make_pair(queryId, std::vector<ResolvedPermissions>())).first;
+            isNewQuery = true;
+        }
+        if (findResolvedPermissions(it->second, dimName, permUAId, permVersion))
+        {
+            return;
+        }
+        ResolvedPermissions item;
+        item.dimName = dimName;
+        item.permUAId = permUAId;
+        item.permVersion = permVersion;
+        item.intervals = intervals;
+        it->second.push_back(item);
+    }
+
+    // Outside of our lock, pushFinalizer takes the lock of the query
+    if (isNewQuery)
+    {
+        query->pushFinalizer(std::bind(&PermissionsContext::release, this, queryId));
+    }
+}
+
+void PermissionsContext::release(QueryID queryId)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queries.erase(queryId);
+    LOG4CXX_DEBUG(logger, "secure_scan::context released for query:" << queryId);
+}
+
+} //namespace scidb
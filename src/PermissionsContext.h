@@ -0,0 +1,99 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file PermissionsContext.h
+ *
+ * @brief Permissions of the user shared by all the secure_scan
+ * operators of a query.
+ *
+ * A query scanning several data arrays, e.g. in a join, reads and
+ * exchanges each permissions array once: the first secure_scan to
+ * execute stores the intervals in the context of the query and the
+ * following ones reuse them, each mapping them onto its own data array.
+ * Since every instance executes the operators of a query in the same
+ * order, all instances agree on which operator does the exchange. The
+ * context of a query is dropped when the query is finalized.
+ */
+
+#ifndef PERMISSIONS_CONTEXT_H_
+#define PERMISSIONS_CONTEXT_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <array/Metadata.h>
+#include <query/Query.h>
+
+#include "PermissionIntervals.h"
+#include "Permissions.h"
+
+namespace scidb
+{
+
+class PermissionsContext
+{
+public:
+    static PermissionsContext* getInstance();
+
+    /**
+     * Look up the intervals of a permission dimension already resolved
+     * in the query.
+     * @param[out] intervals set to the shared intervals on a hit.
+     * @return true on a hit.
+     */
+    bool get(std::shared_ptr<Query> const& query,
+             std::string const& dimName,
+             ArrayUAID permUAId,
+             VersionID permVersion,
+             PermissionIntervals& intervals);
+
+    void put(std::shared_ptr<Query> const& query,
+             std::string const& dimName,
+             ArrayUAID permUAId,
+             VersionID permVersion,
+             PermissionIntervals const& intervals);
+
+private:
+    PermissionsContext()
+    {}
+
+    /**
+     * Drop the context of a query, called when it is finalized.
+     */
+    void release(QueryID queryId);
+
+    typedef std::map<QueryID, std::vector<ResolvedPermissions> > Queries;
+
+    std::mutex _mutex;
+    Queries    _queries;
+};
+
+} //namespace scidb
+
+#endif /* PERMISSIONS_CONTEXT_H_ */
@@ -23,18 +23,31 @@
 * END_COPYRIGHT
 */
 
+#include <algorithm>
 #include <memory>
 
 #include <array/DBArray.h>
 #include <array/Dense1MChunkEstimator.h>
+#include <array/MemArray.h>
 #include <array/Metadata.h>
 #include <query/PhysicalOperator.h>
 #include <query/LogicalOperator.h>
+#include <query/Transaction.h>
 #include <rbac/Session.h>
 #include <system/SystemCatalog.h>
 
 #include "settings.h"
-#include "BetweenArray.h"
+#include "CatalogMemo.h"
+#include "ChunkIndex.h"
+#include "ChunkPlan.h"
+#include "ExplainArray.h"
+#include "PermissionIntervals.h"
+#include "Permissions.h"
+#include "PermissionsCache.h"
+#include "PermissionsContext.h"
+#include "RolePermissions.h"
+#include "SecureArray.h"
+#include "SecureScanStats.h"
 
 using namespace std;
 
@@ -49,14 +62,43 @@ class PhysicalSecureScan: public  PhysicalOperator
                  const std::string& physicalName,
                  const Parameters& parameters,
                  const ArrayDesc& schema):
-    PhysicalOperator(logicalName, physicalName, parameters, schema)
+    PhysicalOperator(logicalName, physicalName, parameters, schema),
+    _explain(false)
     {
-        _arrayName = dynamic_pointer_cast<OperatorParamReference>(parameters[0])->getObjectName();
+        std::shared_ptr<OperatorParamArrayReference> arrayRef =
+            dynamic_pointer_cast<OperatorParamArrayReference>(parameters[0]);
+        _arrayName = arrayRef->getObjectName();
+        _arrayVersion = arrayRef->getVersion();
+        // The optional parameters are told apart by type
+        for (size_t i = 1; i < parameters.size(); i++)
+        {
+            std::shared_ptr<Expression> const& expr =
+                dynamic_pointer_cast<OperatorParamPhysicalExpression>(parameters[i])->getExpression();
+            if (expr->getType() == TID_BOOL)
+            {
+                _explain = expr->evaluate().getBool();
+            }
+            else if (expr->getType() == TID_STRING)
+            {
+                _attrNames.push_back(expr->evaluate().getString());
+            }
+            else
+            {
+                _bounds.push_back(expr->evaluate());
+            }
+        }
     }
 
     virtual RedistributeContext getOutputDistribution(const std::vector<RedistributeContext> & inputDistributions,
                                                       const std::vector< ArrayDesc> & inputSchemas) const
     {
+        if (_explain)
+        {
+            // Each instance only returns its own entries
+            return RedistributeContext(_schema.getDistribution(),
+                                       _schema.getResidency());
+        }
+
         ArrayDistPtr arrDist = _schema.getDistribution();
         SCIDB_ASSERT(arrDist);
         SCIDB_ASSERT(not isUninitialized(_schema.getDistribution()->getDistType()));
@@ -86,21 +128,72 @@ class PhysicalSecureScan: public  PhysicalOperator
         Coordinates lowBoundary = _schema.getLowBoundary();
         Coordinates highBoundary = _schema.getHighBoundary();
 
+        // Shrink the dimensions to the bounds of the scan, if any
+        Coordinates low, high;
+        if (!_explain && getBounds(_schema.getDimensions(), low, high))
+        {
+            for (size_t i = 0; i < low.size(); i++)
+            {
+                lowBoundary[i] = std::max(lowBoundary[i], low[i]);
+                highBoundary[i] = std::min(highBoundary[i], high[i]);
+                if (lowBoundary[i] > highBoundary[i])
+                {
+                    return PhysicalBoundaries::createEmpty(low.size());
+                }
+            }
+        }
+
+        // Shrink the permission dimensions to the span of the
+        // permissions resolved by the coordinator, if any
+        std::vector<PinnedPermissions> pinned;
+        std::vector<ResolvedPermissions> resolved;
+        std::vector<ResolvedRoles> roles;
+        if (!_explain && parsePermissionsCookie(getControlCookie(), pinned, resolved, roles))
+        {
+            Dimensions const& dims = _schema.getDimensions();
+            for (size_t i = 0; i < resolved.size(); i++)
+            {
+                std::vector<PermissionIntervals::Interval> const& intervals =
+                    resolved[i].intervals.intervals();
+                size_t dimIdx = 0;
+                if (intervals.empty() || !findDimension(dims, resolved[i].dimName, dimIdx))
+                {
+                    continue;
+                }
+                lowBoundary[dimIdx] = std::max(lowBoundary[dimIdx], intervals.front().first);
+                highBoundary[dimIdx] = std::min(highBoundary[dimIdx], intervals.back().second);
+                if (lowBoundary[dimIdx] > highBoundary[dimIdx])
+                {
+                    return PhysicalBoundaries::createEmpty(dims.size());
+                }
+            }
+        }
+
         return PhysicalBoundaries(lowBoundary, highBoundary);
     }
 
 
     void inspectLogicalOp(LogicalOperator const& lop) override
     {
-        setControlCookie(lop.getInspectable());
+        std::string cookie = lop.getInspectable();
+        if (cookie != rbac::DBA_USER && cookie != READ_PERM)
+        {
+            std::shared_ptr<Query> query(_query.lock());
+            if (query)
+            {
+                resolvePermissions(query, cookie);
+            }
+        }
+        setControlCookie(cookie);
     }
 
     std::shared_ptr< Array> execute(std::vector< std::shared_ptr< Array> >& inputArrays,
                                     std::shared_ptr<Query> query)
     {
+        ArrayDesc const& dataSchema = getDataSchema(query);
         SCIDB_ASSERT(!_arrayName.empty());
-        SCIDB_ASSERT(_schema.getId() != 0);
-        SCIDB_ASSERT(_schema.getUAId() != 0);
+        SCIDB_ASSERT(dataSchema.getId() != 0);
+        SCIDB_ASSERT(dataSchema.getUAId() != 0);
 
         // Get user ID
         Coordinate userId = query->getSession()->getUser().getId();
@@ -112,242 +205,504 @@ class PhysicalSecureScan: public  PhysicalOperator
         query->getNamespaceArrayNames(_arrayName, dataNSName, dataArrayName);
 
         // Get data array
-        std::shared_ptr<Array> dataArray(DBArray::createDBArray(_schema, query));
+        std::shared_ptr<Array> dataArray(DBArray::createDBArray(dataSchema, query));
+
+        // Get the bounds of the scan, if any
+        Dimensions const& dataDims = dataSchema.getDimensions();
+        Coordinates low, high;
+        bool const isBounded = getBounds(dataDims, low, high);
+        std::vector<bool> clipped(dataDims.size(), false);
 
         if (getControlCookie() == rbac::DBA_USER ||
             getControlCookie() == READ_PERM) {
           // Do privileged stuff
           LOG4CXX_DEBUG(logger, "secure_scan::admin or read permission on namespace");
-          return dataArray;
+          std::shared_ptr<ChunkPlan> plan;
+          if (isBounded)
+          {
+              plan = make_shared<ChunkPlan>();
+              addBounds(*plan, dataDims, low, high, clipped);
+          }
+          if (_explain)
+          {
+              return makeExplainArray(_schema,
+                                      dataSchema,
+                                      dataArray,
+                                      plan,
+                                      std::vector<ResolvedPermissions>(),
+                                      query);
+          }
+          if (_attrNames.empty() && !isBounded)
+          {
+              return dataArray;
+          }
+          if (!plan)
+          {
+              plan = make_shared<ChunkPlan>();
+          }
+          // Not recorded in the statistics, having no query counted
+          return makeSecureArray(dataSchema, plan, dataArray, userId, SecureScanStats::Counters(), query);
         }
 
-        // Get permissions array
-        ArrayDesc permSchema;
-        SystemCatalog::GetArrayDescArgs args;
-        args.nsName = PERM_NS;
-        args.arrayName = PERM_ARRAY;
-
-        args.versionId = LAST_VERSION;
-        args.throwIfNotFound = true;
-        args.result = &permSchema;
-        SystemCatalog::getInstance()->getArrayDesc(args);
-        if (permSchema.isTransient())
-        {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "temporary permissions arrays not supported";
-        }
-        if (permSchema.isAutochunked()) // possibly empty
+        // Get the versions of the permissions arrays pinned and the
+        // permissions and roles resolved by the coordinator, if any.
+        // Every instance then reads the same versions, and all of them
+        // take part in the exchanges or none does.
+        std::vector<PinnedPermissions> pinned;
+        std::vector<ResolvedPermissions> resolved;
+        std::vector<ResolvedRoles> resolvedRoles;
+        bool const isPinned = parsePermissionsCookie(getControlCookie(),
+                                                     pinned,
+                                                     resolved,
+                                                     resolvedRoles);
+
+        // Restrict the data array along the permission dimension, and
+        // along every additional permission dimension it has
+        std::vector<std::string> const permDimNames = getPermDimNames();
+        std::vector<ResolvedPermissions> enforced;
+        std::shared_ptr<ChunkPlan> plan = make_shared<ChunkPlan>();
+        PermissionsCache* cache = PermissionsCache::getInstance();
+        PermissionsContext* context = PermissionsContext::getInstance();
+        SecureScanStats::Counters counters;
+        counters.queries = 1;
+        for (size_t d = 0; d < permDimNames.size(); d++)
         {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "auto-chunked permissions arrays not supported";
-        }
+            std::string const& permDimName = permDimNames[d];
+            bool const isRequired = (d == 0);
 
-        permSchema.setNamespaceName(args.nsName);
-        LOG4CXX_DEBUG(logger, "secure_scan::permSchema:" << permSchema);
+            // Get permission dimension ID for data array
+            size_t dataDimPermIdx = 0;
+            if (!findDimension(dataDims, permDimName, dataDimPermIdx))
+            {
+                if (!isRequired)
+                {
+                    continue;
+                }
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "scanned array does not have a permission dimension";
+            }
+
+            // Get permissions array
+            ArrayDesc permSchema;
+            bool found = false;
+            {
+                SecureScanStats::Timer timer(counters.catalogUsec);
+                found = findPermissionsArray(query,
+                                             permDimName,
+                                             isRequired,
+                                             isPinned ? &pinned : NULL,
+                                             permSchema);
+            }
+            if (!found)
+            {
+                continue;
+            }
+            if (permSchema.isTransient())
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "temporary permissions arrays not supported";
+            }
+            if (permSchema.isAutochunked()) // possibly empty
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "auto-chunked permissions arrays not supported";
+            }
 
-        std::shared_ptr<Array> permArray(DBArray::createDBArray(permSchema, query));
-        LOG4CXX_DEBUG(logger, "secure_scan::permArray:" << permArray);
+            LOG4CXX_DEBUG(logger, "secure_scan::permSchema:" << permSchema);
 
-        // Set cooridnates for permissions array
-        Dimensions const& permDims = permSchema.getDimensions();
-        size_t permNDims = permDims.size();
-        Coordinates permCoordStart(permNDims);
-        Coordinates permCoordEnd(permNDims);
-        size_t permDimPermIdx;
-        bool hasUserDim = false, hasPermDim = false;
-        for (size_t i = 0; i < permNDims; i++)
-        {
-            if (permDims[i].hasNameAndAlias(USER_DIM))
+            // Get user and permission dimension IDs for permissions array
+            Dimensions const& permDims = permSchema.getDimensions();
+            size_t permDimUserIdx = 0;
+            if (!findDimension(permDims, USER_DIM, permDimUserIdx))
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "permissions array does not have an user ID dimension";
+            }
+            PermissionsLayout layout;
+            if (!findPermissionsLayout(permSchema, permDimName, permDimUserIdx, layout))
             {
-                hasUserDim = true;
-                permCoordStart[i] = userId;
-                permCoordEnd[i] = userId;
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "permissions array does not have a permission dimension";
+            }
+
+            // Use the permissions resolved by the coordinator or by an
+            // earlier secure_scan of the query if any, otherwise read
+            // them from all instances, along with those of the roles of
+            // the user
+            PermissionIntervals permIntervals;
+            ResolvedPermissions const* item = findResolvedPermissions(resolved,
+                                                                      permDimName,
+                                                                      permSchema.getUAId(),
+                                                                      permSchema.getVersionId());
+            if (item)
+            {
+                LOG4CXX_DEBUG(logger, "secure_scan::permissions resolved by coordinator:" << permDimName);
+                permIntervals = item->intervals;
+            }
+            else if (context->get(query,
+                                  permDimName,
+                                  permSchema.getUAId(),
+                                  permSchema.getVersionId(),
+                                  permIntervals))
+            {
+                LOG4CXX_DEBUG(logger, "secure_scan::permissions shared in query:" << permDimName);
             }
             else
             {
-                permCoordStart[i] = permDims[i].getStartMin();
-                permCoordEnd[i] = permDims[i].getEndMax();
+                PermissionIntervals localIntervals;
+                {
+                    SecureScanStats::Timer timer(counters.readUsec);
+                    localIntervals = readLocalPermissions(permSchema,
+                                                          layout,
+                                                          userId,
+                                                          query);
+                }
+                {
+                    SecureScanStats::Timer timer(counters.exchangeUsec);
+                    permIntervals = exchangePermissions(localIntervals, query);
+                }
+                cache->put(userId,
+                           permSchema.getUAId(),
+                           permSchema.getVersionId(),
+                           permIntervals);
+
+                RoleArrays roles;
+                if (findRoleArrays(query, permDimName, isPinned ? &pinned : NULL, roles))
+                {
+                    SecureScanStats::Timer timer(counters.exchangeUsec);
+                    permIntervals.merge(readRolePermissions(roles,
+                                                            userId,
+                                                            findResolvedRoles(resolvedRoles,
+                                                                              permDimName),
+                                                            query));
+                }
+            }
+            context->put(query,
+                         permDimName,
+                         permSchema.getUAId(),
+                         permSchema.getVersionId(),
+                         permIntervals);
+
+            if (permIntervals.empty())
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "user has no permissions in the scanned array";
+            }
+            counters.permittedCells += permIntervals.cardinality();
+            counters.ranges += permIntervals.size();
+
+            // Only the permitted coordinates within the bounds are read
+            if (isBounded)
+            {
+                permIntervals.clip(low[dataDimPermIdx], high[dataDimPermIdx]);
+                clipped[dataDimPermIdx] = true;
             }
-            if (permDims[i].hasNameAndAlias(PERM_DIM))
+
+            // Map the permissions onto the data array chunks
+            plan->addDimension(permIntervals, dataDims, dataDimPermIdx);
+            if (_explain)
             {
-                hasPermDim = true;
-                permDimPermIdx = i;
+                ResolvedPermissions item;
+                item.dimName = permDimName;
+                item.permUAId = permSchema.getUAId();
+                item.permVersion = permSchema.getVersionId();
+                item.intervals = permIntervals;
+                enforced.push_back(item);
             }
-            LOG4CXX_DEBUG(logger, "secure_scan::permCoordStart[" << i << "]:" << permCoordStart[i]);
-            LOG4CXX_DEBUG(logger, "secure_scan::permCoordEnd[" << i << "]:" << permCoordEnd[i]);
         }
-        if (!hasUserDim)
+
+        if (isBounded)
         {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "permissions array does not have an user ID dimension";
+            addBounds(*plan, dataDims, low, high, clipped);
         }
-        if (!hasPermDim)
+
+        if (_explain)
         {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "permissions array does not have a permission dimension";
+            return makeExplainArray(_schema, dataSchema, dataArray, plan, enforced, query);
         }
+        return makeSecureArray(dataSchema, plan, dataArray, userId, counters, query);
+    }
 
-        // Build spatial range for permissions array
-        SpatialRangesPtr permSpatialRangesPtr = make_shared<SpatialRanges>(permNDims);
-        permSpatialRangesPtr->insert(SpatialRange(permCoordStart, permCoordEnd));
-        permSpatialRangesPtr->buildIndex();
-
-        // Add between for permissions array
-        std::shared_ptr<Array> permBetweenArray(
-            make_shared<BetweenArray>(permSchema,
-                                      permSpatialRangesPtr,
-                                      permArray));
-        LOG4CXX_DEBUG(logger, "secure_scan::permBetweenArray:" << permBetweenArray);
-
-        // Redistribute permissions array
-        std::shared_ptr<Array> permRedistArray = redistributeToRandomAccess(
-            permBetweenArray,
-            createDistribution(dtReplication),
-            permSchema.getResidency(),
-            query,
-            shared_from_this(),
-            true);
-
-        // Set cooridnates for data array
-        Dimensions const& dataDims = _schema.getDimensions();
-        size_t dataNDims = dataDims.size();
-
-        // Get permission dimension ID
-        size_t dataDimPermIdx = 0;
-        hasPermDim = false;
-        for (size_t i = 0; i < dataNDims; i++)
+  private:
+    /**
+     * @return the array of the cells of the data array that the plan
+     * permits, with the attributes of the output schema.
+     */
+    std::shared_ptr<Array> makeSecureArray(ArrayDesc const& dataSchema,
+                                           std::shared_ptr<ChunkPlan> const& plan,
+                                           std::shared_ptr<Array> const& dataArray,
+                                           Coordinate userId,
+                                           SecureScanStats::Counters const& counters,
+                                           std::shared_ptr<Query> const& query)
+    {
+        // Visit the permitted chunks of the local index, or the
+        // permitted chunks this instance should hold
+        shared_ptr<vector<Coordinates> const> chunks =
+            ChunkIndex::getInstance()->listChunks(dataSchema, dataArray, *plan, query);
+        if (!chunks)
+        {
+            chunks = listLocalChunks(dataSchema, *plan, query);
+        }
+        if (chunks && chunks->empty())
         {
-            if (dataDims[i].hasNameAndAlias(PERM_DIM))
+            // None of the permitted chunks is stored on this instance,
+            // the scan is still counted as the SecureArray would
+            if (counters.queries > 0)
             {
-                dataDimPermIdx = i;
-                hasPermDim = true;
-                break;
+                SecureScanStats::getInstance()->add(userId, counters);
             }
+            return make_shared<MemArray>(_schema, query);
+        }
+        return make_shared<SecureArray>(
+            _schema, plan, dataArray, userId, counters, chunks, query);
+    }
+
+    /**
+     * Get the bounds of the scan along each dimension. Null bounds are
+     * rejected by the logical operator.
+     * @return false if the scan has no bounds.
+     */
+    bool getBounds(Dimensions const& dims, Coordinates& low, Coordinates& high) const
+    {
+        if (_bounds.empty())
+        {
+            return false;
         }
-        if (!hasPermDim)
+        SCIDB_ASSERT(_bounds.size() == 2 * dims.size());
+        low.resize(dims.size());
+        high.resize(dims.size());
+        for (size_t i = 0; i < dims.size(); i++)
         {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "scanned array does not have a permission dimension";
+            low[i] = _bounds[i].getInt64();
+            high[i] = _bounds[dims.size() + i].getInt64();
         }
+        return true;
+    }
 
-        // Build spatial range for data array
-        Coordinates dataCoordStart(dataNDims);
-        Coordinates dataCoordEnd(dataNDims);
-        bool is_first_time = true;
-        SpatialRangesPtr dataSpatialRangesPtr = make_shared<SpatialRanges>(dataNDims);
-        shared_ptr<ConstArrayIterator> aiter = permRedistArray->getConstIterator(permRedistArray->getArrayDesc().getAttributes().firstDataAttribute());
-        hasPermDim = false;
-        for (size_t i = 0; i < dataNDims; i++)
+    /**
+     * Restrict the plan to the bounds of the scan along the dimensions
+     * whose permissions were not clipped to the bounds. A bound beyond
+     * the data in the array, when known, does not restrict the scan.
+     */
+    static void addBounds(ChunkPlan& plan,
+                          Dimensions const& dims,
+                          Coordinates const& low,
+                          Coordinates const& high,
+                          std::vector<bool> const& clipped)
+    {
+        for (size_t i = 0; i < dims.size(); i++)
         {
-            if (dataDims[i].hasNameAndAlias(PERM_DIM))
+            Coordinate dimLow = low[i];
+            Coordinate dimHigh = high[i];
+            if (dims[i].getCurrStart() <= dims[i].getCurrEnd())
+            {
+                if (dimLow <= dims[i].getCurrStart())
+                {
+                    dimLow = dims[i].getStartMin();
+                }
+                if (dimHigh >= dims[i].getCurrEnd())
+                {
+                    dimHigh = dims[i].getEndMax();
+                }
+            }
+            if (clipped[i] || (dimLow <= dims[i].getStartMin() && dimHigh >= dims[i].getEndMax()))
+            {
+                continue;
+            }
+            PermissionIntervals bounds;
+            if (dimLow <= dimHigh)
             {
-                dataDimPermIdx = i;
-                hasPermDim = true;
-                break;
+                bounds.append(dimLow, dimHigh);
             }
+            plan.addDimension(bounds, dims, i);
+        }
+    }
+
+    /**
+     * @return the schema of the scanned array. It is the output schema,
+     * except in explain mode or when only some attributes are returned,
+     * where it is read from the catalog.
+     */
+    ArrayDesc const& getDataSchema(std::shared_ptr<Query> const& query)
+    {
+        if (!_explain && _attrNames.empty())
+        {
+            return _schema;
+        }
+        if (_dataSchema.getId() == 0)
+        {
+            SystemCatalog::GetArrayDescArgs args;
+            query->getNamespaceArrayNames(_arrayName, args.nsName, args.arrayName);
+            args.catalogVersion = query->getTxn().getCatalogVersion(args.nsName, args.arrayName);
+            args.versionId = _arrayVersion;
+            args.throwIfNotFound = true;
+            args.result = &_dataSchema;
+            CatalogMemo::getInstance()->getArrayDesc(query, args);
+            _dataSchema.setNamespaceName(args.nsName);
         }
-        if (!hasPermDim)
+        return _dataSchema;
+    }
+
+    /**
+     * List the permitted chunks of a hash-partitioned data array that
+     * this instance holds, so that the scan visits them directly.
+     * @return null if the chunks cannot be located from the schema or
+     * if there are more than PERM_CHUNK_LIST_MAX permitted chunks, the
+     * scan then walks every local chunk.
+     */
+    static std::shared_ptr<std::vector<Coordinates> const> listLocalChunks(
+        ArrayDesc const& dataSchema,
+        ChunkPlan const& plan,
+        std::shared_ptr<Query> const& query)
+    {
+        std::shared_ptr<std::vector<Coordinates> > chunks;
+        if (plan.getDimensions().empty() ||
+            dataSchema.getDistribution()->getDistType() != dtHashPartitioned ||
+            query->isDistributionDegradedForRead(dataSchema))
+        {
+            return chunks;
+        }
+
+        std::vector<Coordinates> permitted;
+        if (!plan.listChunks(dataSchema.getDimensions(),
+                             dataSchema.getLowBoundary(),
+                             dataSchema.getHighBoundary(),
+                             PERM_CHUNK_LIST_MAX,
+                             permitted))
         {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "scanned array does not have a permission dimension";
+            return chunks;
         }
 
-        // Collect permission coordinates
-        Coordinates permCoords;
-        while (!aiter->end())
+        ArrayDistPtr const& dist = dataSchema.getDistribution();
+        ArrayResPtr const& residency = dataSchema.getResidency();
+        InstanceID const myId = query->getPhysicalInstanceID();
+        chunks = std::make_shared<std::vector<Coordinates> >();
+        for (size_t i = 0; i < permitted.size(); i++)
         {
-            ConstChunk const* chunk = &(aiter->getChunk());
-            shared_ptr<ConstChunkIterator> citer =
-                chunk->getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
-            while (!citer->end())
+            InstanceID const owner = dist->getPrimaryChunkLocation(permitted[i],
+                                                                   dataSchema.getDimensions(),
+                                                                   residency->size());
+            if (residency->getPhysicalInstanceAt(owner) == myId)
             {
-                if (citer->getItem().getBool())
-                {
-                    Coordinates const permCoord = citer->getPosition();
-                    permCoords.push_back(permCoord[permDimPermIdx]);
-                }
-                ++(*citer);
+                chunks->push_back(permitted[i]);
             }
-            ++(*aiter);
         }
+        LOG4CXX_DEBUG(logger, "secure_scan::permitted chunks:" << permitted.size()
+                      << " local:" << chunks->size());
+        return chunks;
+    }
 
-        // Sort permission coordinates so we can collapse them
-        std::sort(permCoords.begin(), permCoords.end());
-
-        // Collapse permission coordinates and build spatial range for data array
-        bool isFirstTime = true;
-        for (Coordinates::iterator permCoordIter = permCoords.begin();
-             permCoordIter != permCoords.end();
-             ++permCoordIter)
+    /**
+     * Pin the versions of the permissions arrays on the coordinator,
+     * and resolve the permissions of the user if possible, then ship
+     * both to the workers in the control cookie. For each permission
+     * dimension, the permissions of the user and of its roles are taken
+     * from the coordinator cache, or read locally if the arrays are
+     * replicated.
+     * Otherwise the workers read them at execute time, at the pinned
+     * versions, which is also where errors in the permissions arrays
+     * are reported. The roles found in the cache are shipped even if
+     * the permissions of the user are not, so that the workers only
+     * read the roles missing here.
+     */
+    void resolvePermissions(std::shared_ptr<Query> const& query, std::string& cookie)
+    {
+        Coordinate userId = query->getSession()->getUser().getId();
+        PermissionsCache* cache = PermissionsCache::getInstance();
+        Dimensions const& dataDims = getDataSchema(query).getDimensions();
+        std::vector<PinnedPermissions> const pinned = pinPermissions(query);
+        std::vector<ResolvedPermissions> resolved;
+        std::vector<ResolvedRoles> resolvedRoles;
+        for (size_t d = 0; d < pinned.size(); d++)
         {
-            if (isFirstTime)
+            std::string const& permDimName = pinned[d].dimName;
+            size_t dataDimPermIdx = 0;
+            if (!findDimension(dataDims, permDimName, dataDimPermIdx))
+            {
+                continue;
+            }
+
+            ArrayDesc permSchema;
+            if (!findPermissionsArray(query, permDimName, false, &pinned, permSchema) ||
+                permSchema.isTransient() ||
+                permSchema.isAutochunked())
+            {
+                continue;
+            }
+
+            size_t permDimUserIdx = 0;
+            PermissionsLayout layout;
+            if (!findDimension(permSchema.getDimensions(), USER_DIM, permDimUserIdx) ||
+                !findPermissionsLayout(permSchema, permDimName, permDimUserIdx, layout))
+            {
+                continue;
+            }
+
+            ResolvedPermissions item;
+            item.dimName = permDimName;
+            item.permUAId = permSchema.getUAId();
+            item.permVersion = permSchema.getVersionId();
+            bool isResolved = cache->get(userId, item.permUAId, item.permVersion, item.intervals);
+            if (!isResolved && permSchema.getDistribution()->getDistType() == dtReplication)
+            {
+                item.intervals = readLocalPermissions(permSchema,
+                                                      layout,
+                                                      userId,
+                                                      query);
+                cache->put(userId, item.permUAId, item.permVersion, item.intervals);
+                isResolved = true;
+            }
+
+            // The roles are resolved even if the permissions of the
+            // user are not, so that the workers only read the roles
+            // missing here. The workers report the errors in the role
+            // arrays.
+            bool hasRoles = false;
+            ResolvedRoles itemRoles;
+            itemRoles.dimName = permDimName;
+            try
             {
-                // First time
-                for (size_t i = 0; i < dataNDims; i++)
+                RoleArrays roles;
+                if (findRoleArrays(query, permDimName, &pinned, roles))
                 {
-                    if (i == dataDimPermIdx)
+                    hasRoles = true;
+                    if (!resolveRoles(roles, userId, query, itemRoles))
                     {
-                        dataCoordStart[i] = *permCoordIter;
-                        dataCoordEnd[i]   = *permCoordIter;
+                        continue;
                     }
-                    else
-                    {
-                        dataCoordStart[i] = dataDims[i].getStartMin();
-                        dataCoordEnd[i]   = dataDims[i].getEndMax();
-                    }
-                    LOG4CXX_DEBUG(logger, "secure_scan::dataCoordStart[" << i << "]:" << dataCoordStart[i]);
-                    LOG4CXX_DEBUG(logger, "secure_scan::dataCoordEnd["   << i << "]:" << dataCoordEnd[i]);
                 }
-                isFirstTime = false;
-                // Do not create spatial range just yet
             }
-            else
+            catch (Exception const&)
             {
-                // Check if the previous and the curent
-                // coordinates are sequential
-                if (dataCoordEnd[dataDimPermIdx] + 1 == *permCoordIter)
-                {
-                    // Just update the end
-                    ++dataCoordEnd[dataDimPermIdx];
-                    // Do not create spatial range just yet
-                }
-                else
-                {
-                    // Coordiantes skip
-                    // Create spatial range for previous coordinate pair
-                    LOG4CXX_DEBUG(logger, "secure_scan::SpatialRange:" << dataCoordStart[dataDimPermIdx] << ","
-                                  << dataCoordEnd[dataDimPermIdx]);
-                    dataSpatialRangesPtr->insert(SpatialRange(dataCoordStart, dataCoordEnd));
-                    // Update permission coordinate
-                    dataCoordStart[dataDimPermIdx] = *permCoordIter;
-                    dataCoordEnd[dataDimPermIdx]   = *permCoordIter;
-                    // Do not create spatial range just yet
-                }
+                continue;
             }
-        }
-        if (!isFirstTime)
-        {
-            // Create spatial range from outstanding coordinate pair
-            LOG4CXX_DEBUG(logger, "secure_scan::SpatialRange:" << dataCoordStart[dataDimPermIdx] << ","
-                          << dataCoordEnd[dataDimPermIdx]);
-            dataSpatialRangesPtr->insert(SpatialRange(dataCoordStart, dataCoordEnd));
-        }
-        if (dataSpatialRangesPtr->ranges().size() == 0)
-        {
-            throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
-                << "user has no permissions in the scanned array";
-        }
-        dataSpatialRangesPtr->buildIndex();
 
-        // Add between for data array
-        std::shared_ptr<Array> dataBetweenArray(
-            make_shared<BetweenArray>(_schema, dataSpatialRangesPtr, dataArray));
+            if (isResolved && (!hasRoles || itemRoles.missingIds.empty()))
+            {
+                item.intervals.merge(itemRoles.intervals);
+                LOG4CXX_DEBUG(logger, "secure_scan::coordinator resolved " << permDimName
+                              << " intervals:" << item.intervals.size());
+                resolved.push_back(item);
+            }
+            else if (hasRoles)
+            {
+                resolvedRoles.push_back(itemRoles);
+            }
+        }
 
-        return dataBetweenArray;
+        cookie = makePermissionsCookie(pinned, resolved, resolvedRoles);
     }
 
   private:
-    string _arrayName;
+    string    _arrayName;
+    VersionID _arrayVersion;
+    bool      _explain;
+    ArrayDesc _dataSchema;
+
+    // The attributes to return, all of them if empty, and the low then
+    // high bounds along each dimension, none if empty
+    std::vector<std::string> _attrNames;
+    std::vector<Value>       _bounds;
 };
 
 REGISTER_PHYSICAL_OPERATOR_FACTORY(PhysicalSecureScan, "secure_scan", "PhysicalSecureScan");
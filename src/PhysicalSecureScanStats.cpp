@@ -0,0 +1,120 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <log4cxx/logger.h>
+#include <array/MemArray.h>
+#include <query/PhysicalOperator.h>
+
+#include "SecureScanStats.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+class PhysicalSecureScanStats: public  PhysicalOperator
+{
+  public:
+    PhysicalSecureScanStats(const std::string& logicalName,
+                            const std::string& physicalName,
+                            const Parameters& parameters,
+                            const ArrayDesc& schema):
+    PhysicalOperator(logicalName, physicalName, parameters, schema)
+    {}
+
+    virtual RedistributeContext getOutputDistribution(const std::vector<RedistributeContext> & inputDistributions,
+                                                      const std::vector< ArrayDesc> & inputSchemas) const
+    {
+        // Each instance only returns its own cells
+        return RedistributeContext(_schema.getDistribution(),
+                                   _schema.getResidency());
+    }
+
+    std::shared_ptr< Array> execute(std::vector< std::shared_ptr< Array> >& inputArrays,
+                                    std::shared_ptr<Query> query)
+    {
+        std::shared_ptr<Array> result = make_shared<MemArray>(_schema, query);
+        SecureScanStats::UserCounters const users = SecureScanStats::getInstance()->get();
+        LOG4CXX_DEBUG(logger, "secure_scan::stats users:" << users.size());
+
+        Attributes const& attrs = _schema.getAttributes(true);
+        std::vector<std::shared_ptr<ArrayIterator> > aiters;
+        for (auto const& attr : attrs)
+        {
+            aiters.push_back(result->getIterator(attr));
+        }
+        std::vector<std::shared_ptr<ChunkIterator> > citers(aiters.size());
+
+        // Users are in order, so each chunk is filled at once
+        Coordinates pos(2);
+        pos[0] = query->getInstanceID();
+        Coordinates chunkPos;
+        for (SecureScanStats::UserCounters::const_iterator it = users.begin(); it != users.end(); ++it)
+        {
+            pos[1] = it->first;
+            Coordinates userChunkPos = pos;
+            _schema.getChunkPositionFor(userChunkPos);
+            if (userChunkPos != chunkPos)
+            {
+                chunkPos = userChunkPos;
+                for (size_t i = 0; i < aiters.size(); i++)
+                {
+                    if (citers[i])
+                    {
+                        citers[i]->flush();
+                    }
+                    Chunk& chunk = aiters[i]->newChunk(chunkPos);
+                    citers[i] = chunk.getIterator(query,
+                                                  i == 0
+                                                  ? ChunkIterator::SEQUENTIAL_WRITE
+                                                  : ChunkIterator::SEQUENTIAL_WRITE |
+                                                    ChunkIterator::NO_EMPTY_CHECK);
+                }
+            }
+
+            std::vector<uint64_t> const values = it->second.getValues();
+            for (size_t i = 0; i < citers.size(); i++)
+            {
+                Value value;
+                value.setUint64(values[i]);
+                citers[i]->setPosition(pos);
+                citers[i]->writeItem(value);
+            }
+        }
+        for (size_t i = 0; i < citers.size(); i++)
+        {
+            if (citers[i])
+            {
+                citers[i]->flush();
+            }
+        }
+        return result;
+    }
+};
+
+REGISTER_PHYSICAL_OPERATOR_FACTORY(PhysicalSecureScanStats, "secure_scan_stats", "PhysicalSecureScanStats");
+
+} //namespace scidb
@@ -0,0 +1,312 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include <log4cxx/logger.h>
+#include <array/DBArray.h>
+#include <array/MemArray.h>
+#include <query/LogicalOperator.h>
+#include <query/PhysicalOperator.h>
+#include <query/Transaction.h>
+#include <system/SystemCatalog.h>
+
+#include "settings.h"
+#include "CatalogMemo.h"
+#include "ChunkPlan.h"
+#include "Permissions.h"
+#include "PermissionsCache.h"
+#include "RolePermissions.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+class PhysicalSecureScanUsers: public  PhysicalOperator
+{
+  public:
+    PhysicalSecureScanUsers(const std::string& logicalName,
+                            const std::string& physicalName,
+                            const Parameters& parameters,
+                            const ArrayDesc& schema):
+    PhysicalOperator(logicalName, physicalName, parameters, schema)
+    {
+        std::shared_ptr<OperatorParamArrayReference> arrayRef =
+            dynamic_pointer_cast<OperatorParamArrayReference>(parameters[0]);
+        _arrayName = arrayRef->getObjectName();
+        _arrayVersion = arrayRef->getVersion();
+        for (size_t i = 1; i < parameters.size(); i++)
+        {
+            _userIds.push_back(dynamic_pointer_cast<OperatorParamPhysicalExpression>(
+                parameters[i])->getExpression()->evaluate().getInt64());
+        }
+
+        // Every instance reads the permissions of the users in the same order
+        std::sort(_userIds.begin(), _userIds.end());
+        _userIds.erase(std::unique(_userIds.begin(), _userIds.end()), _userIds.end());
+    }
+
+    virtual RedistributeContext getOutputDistribution(const std::vector<RedistributeContext> & inputDistributions,
+                                                      const std::vector< ArrayDesc> & inputSchemas) const
+    {
+        // Each instance only returns the cells of its own chunks
+        return RedistributeContext(_schema.getDistribution(),
+                                   _schema.getResidency());
+    }
+
+    void inspectLogicalOp(LogicalOperator const& lop) override
+    {
+        // Pin the versions of the permissions arrays read by every
+        // instance, under the locks taken by the logical operator
+        std::shared_ptr<Query> query(_query.lock());
+        if (query)
+        {
+            setControlCookie(makePermissionsCookie(pinPermissions(query),
+                                                   std::vector<ResolvedPermissions>(),
+                                                   std::vector<ResolvedRoles>()));
+        }
+    }
+
+    std::shared_ptr< Array> execute(std::vector< std::shared_ptr< Array> >& inputArrays,
+                                    std::shared_ptr<Query> query)
+    {
+        ArrayDesc dataSchema;
+        SystemCatalog::GetArrayDescArgs dataArgs;
+        query->getNamespaceArrayNames(_arrayName, dataArgs.nsName, dataArgs.arrayName);
+        dataArgs.catalogVersion = query->getTxn().getCatalogVersion(dataArgs.nsName, dataArgs.arrayName);
+        dataArgs.versionId = _arrayVersion;
+        dataArgs.throwIfNotFound = true;
+        dataArgs.result = &dataSchema;
+        CatalogMemo::getInstance()->getArrayDesc(query, dataArgs);
+        dataSchema.setNamespaceName(dataArgs.nsName);
+
+        // Build the chunk plan of every user. Each permissions array and
+        // role array is read once for all the users, and exchanged in
+        // one round.
+        Dimensions const& dataDims = dataSchema.getDimensions();
+        std::vector<std::string> const permDimNames = getPermDimNames();
+        std::vector<PinnedPermissions> pinned;
+        std::vector<ResolvedPermissions> resolved;
+        std::vector<ResolvedRoles> resolvedRoles;
+        bool const isPinned = parsePermissionsCookie(getControlCookie(),
+                                                     pinned,
+                                                     resolved,
+                                                     resolvedRoles);
+        std::vector<std::shared_ptr<ChunkPlan> > plans;
+        for (size_t u = 0; u < _userIds.size(); u++)
+        {
+            plans.push_back(make_shared<ChunkPlan>());
+        }
+        PermissionsCache* cache = PermissionsCache::getInstance();
+        for (size_t d = 0; d < permDimNames.size(); d++)
+        {
+            std::string const& permDimName = permDimNames[d];
+            bool const isRequired = (d == 0);
+
+            size_t dataDimPermIdx = 0;
+            if (!findDimension(dataDims, permDimName, dataDimPermIdx))
+            {
+                if (!isRequired)
+                {
+                    continue;
+                }
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "scanned array does not have a permission dimension";
+            }
+
+            ArrayDesc permSchema;
+            if (!findPermissionsArray(query,
+                                      permDimName,
+                                      isRequired,
+                                      isPinned ? &pinned : NULL,
+                                      permSchema))
+            {
+                continue;
+            }
+            if (permSchema.isTransient())
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "temporary permissions arrays not supported";
+            }
+            if (permSchema.isAutochunked())
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "auto-chunked permissions arrays not supported";
+            }
+
+            size_t permDimUserIdx = 0;
+            if (!findDimension(permSchema.getDimensions(), USER_DIM, permDimUserIdx))
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "permissions array does not have an user ID dimension";
+            }
+            PermissionsLayout layout;
+            if (!findPermissionsLayout(permSchema, permDimName, permDimUserIdx, layout))
+            {
+                throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+                    << "permissions array does not have a permission dimension";
+            }
+
+            std::vector<PermissionIntervals> permIntervals = exchangePermissions(
+                readLocalPermissions(permSchema, layout, _userIds, query),
+                query);
+            for (size_t u = 0; u < _userIds.size(); u++)
+            {
+                cache->put(_userIds[u],
+                           permSchema.getUAId(),
+                           permSchema.getVersionId(),
+                           permIntervals[u]);
+            }
+            RoleArrays roles;
+            if (findRoleArrays(query, permDimName, isPinned ? &pinned : NULL, roles))
+            {
+                std::vector<PermissionIntervals> const roleIntervals =
+                    readRolePermissions(roles, _userIds, query);
+                for (size_t u = 0; u < _userIds.size(); u++)
+                {
+                    permIntervals[u].merge(roleIntervals[u]);
+                }
+            }
+            for (size_t u = 0; u < _userIds.size(); u++)
+            {
+                plans[u]->addDimension(permIntervals[u], dataDims, dataDimPermIdx);
+            }
+        }
+
+        // The output of all the users is materialized on each instance,
+        // which bounds the number of users to PERM_SCAN_USERS_MAX.
+        // Each data chunk position is visited once: the chunk plan and
+        // the mask of every user are computed once, for all attributes.
+        std::shared_ptr<Array> dataArray(DBArray::createDBArray(dataSchema, query));
+        std::shared_ptr<Array> result = make_shared<MemArray>(_schema, query);
+        Attributes const& dataAttrs = dataSchema.getAttributes(true);
+        Attributes const& attrs = _schema.getAttributes(true);
+        std::vector<shared_ptr<ConstArrayIterator> > aiters;
+        std::vector<shared_ptr<ArrayIterator> > oaiters;
+        Attributes::const_iterator dataAttr = dataAttrs.begin();
+        for (auto const& attr : attrs)
+        {
+            aiters.push_back(dataArray->getConstIterator(*dataAttr));
+            oaiters.push_back(result->getIterator(attr));
+            ++dataAttr;
+        }
+
+        size_t nChunks = 0, nUserChunks = 0;
+        std::vector<std::vector<size_t> > hints(_userIds.size());
+        std::vector<ChunkPlan::Kind> kinds(_userIds.size());
+        std::vector<ChunkPlan::Mask> masks(_userIds.size());
+        std::vector<std::shared_ptr<ChunkIterator> > citers(_userIds.size());
+        Coordinates outPos(dataDims.size() + 1);
+        for (; !aiters.front()->end(); ++(*aiters.front()))
+        {
+            // Each chunk is read once, for all the users that see it
+            Coordinates const chunkPos = aiters.front()->getPosition();
+            std::vector<size_t> users;
+            for (size_t u = 0; u < _userIds.size(); u++)
+            {
+                kinds[u] = plans[u]->getKind(chunkPos, hints[u]);
+                if (kinds[u] != ChunkPlan::SKIP)
+                {
+                    users.push_back(u);
+                }
+            }
+            if (users.empty())
+            {
+                continue;
+            }
+            nChunks++;
+            nUserChunks += users.size();
+
+            for (size_t a = 0; a < aiters.size(); a++)
+            {
+                if (a > 0 && !aiters[a]->setPosition(chunkPos))
+                {
+                    continue;
+                }
+                ConstChunk const& chunk = aiters[a]->getChunk();
+                std::copy(chunkPos.begin(), chunkPos.end(), outPos.begin() + 1);
+                for (size_t i = 0; i < users.size(); i++)
+                {
+                    size_t const u = users[i];
+                    if (a == 0 && kinds[u] == ChunkPlan::MASKED)
+                    {
+                        masks[u].reset(*plans[u],
+                                       chunkPos,
+                                       chunk.getFirstPosition(true),
+                                       chunk.getLastPosition(true));
+                    }
+                    outPos[0] = _userIds[u];
+                    Chunk& outChunk = oaiters[a]->newChunk(outPos);
+                    citers[u] = outChunk.getIterator(query,
+                                                     a == 0
+                                                     ? ChunkIterator::SEQUENTIAL_WRITE
+                                                     : ChunkIterator::SEQUENTIAL_WRITE |
+                                                       ChunkIterator::NO_EMPTY_CHECK);
+                }
+
+                shared_ptr<ConstChunkIterator> citer =
+                    chunk.getConstIterator(ConstChunkIterator::IGNORE_OVERLAPS);
+                while (!citer->end())
+                {
+                    Coordinates const& pos = citer->getPosition();
+                    Value const& value = citer->getItem();
+                    std::copy(pos.begin(), pos.end(), outPos.begin() + 1);
+                    for (size_t i = 0; i < users.size(); i++)
+                    {
+                        size_t const u = users[i];
+                        if (kinds[u] == ChunkPlan::PASS_THROUGH || masks[u].isPermitted(pos))
+                        {
+                            outPos[0] = _userIds[u];
+                            citers[u]->setPosition(outPos);
+                            citers[u]->writeItem(value);
+                        }
+                    }
+                    ++(*citer);
+                }
+
+                for (size_t i = 0; i < users.size(); i++)
+                {
+                    citers[users[i]]->flush();
+                    citers[users[i]].reset();
+                }
+            }
+        }
+        LOG4CXX_DEBUG(logger, "secure_scan::users:" << _userIds.size()
+                      << " chunks read:" << nChunks
+                      << " chunks returned:" << nUserChunks);
+        return result;
+    }
+
+  private:
+    string                  _arrayName;
+    VersionID               _arrayVersion;
+    std::vector<Coordinate> _userIds;
+};
+
+REGISTER_PHYSICAL_OPERATOR_FACTORY(PhysicalSecureScanUsers, "secure_scan_users", "PhysicalSecureScanUsers");
+
+} //namespace scidb
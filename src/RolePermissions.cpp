@@ -0,0 +1,310 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include <log4cxx/logger.h>
+#include <system/SystemCatalog.h>
+
+#include "settings.h"
+#include "CatalogMemo.h"
+#include "PermissionsCache.h"
+#include "RolePermissions.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+/**
+ * Look up a role array and check that it has the layout of a
+ * permissions array along permDimName, keyed by keyDimName.
+ * @param versionId the version to read, LAST_VERSION if not pinned.
+ * @return false if the array does not exist.
+ */
+static bool findRoleArray(std::shared_ptr<Query> const& query,
+                          std::string const& arrayName,
+                          VersionID versionId,
+                          std::string const& keyDimName,
+                          std::string const& permDimName,
+                          ArrayDesc& schema,
+                          PermissionsLayout& layout)
+{
+    SystemCatalog::GetArrayDescArgs args;
+    args.nsName = PERM_NS;
+    args.arrayName = arrayName;
+    args.versionId = versionId;
+    args.throwIfNotFound = (versionId != LAST_VERSION);
+    args.result = &schema;
+    if (!CatalogMemo::getInstance()->getArrayDesc(query, args))
+    {
+        return false;
+    }
+    if (schema.isTransient() || schema.isAutochunked())
+    {
+        throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+            << "temporary and auto-chunked role arrays not supported";
+    }
+    schema.setNamespaceName(args.nsName);
+
+    size_t keyDimIdx = 0;
+    if (!findDimension(schema.getDimensions(), keyDimName, keyDimIdx))
+    {
+        throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+            << "role array " << arrayName << " does not have a " << keyDimName << " dimension";
+    }
+    if (!findPermissionsLayout(schema, permDimName, keyDimIdx, layout))
+    {
+        throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+            << "role array " << arrayName << " does not have a " << permDimName << " dimension";
+    }
+    return true;
+}
+
+bool findRoleArrays(std::shared_ptr<Query> const& query,
+                    std::string const& permDimName,
+                    std::vector<PinnedPermissions> const* pinned,
+                    RoleArrays& roles)
+{
+    VersionID grantsVersion = LAST_VERSION;
+    VersionID membersVersion = LAST_VERSION;
+    if (pinned)
+    {
+        PinnedPermissions const* item = findPinnedPermissions(*pinned, permDimName);
+        if (!item || item->grantsVersion == 0 || item->membersVersion == 0)
+        {
+            return false;
+        }
+        grantsVersion = item->grantsVersion;
+        membersVersion = item->membersVersion;
+    }
+
+    return findRoleArray(query,
+                         getPermArrayName(permDimName) + ROLE_ARRAY_SUFFIX,
+                         grantsVersion,
+                         ROLE_DIM,
+                         permDimName,
+                         roles.grantsSchema,
+                         roles.grantsLayout) &&
+        findRoleArray(query,
+                      ROLE_MEMBERS_ARRAY,
+                      membersVersion,
+                      USER_DIM,
+                      ROLE_DIM,
+                      roles.membersSchema,
+                      roles.membersLayout);
+}
+
+/**
+ * @return the IDs of the roles in a set.
+ */
+static std::vector<Coordinate> listRoles(PermissionIntervals const& roleIds)
+{
+    if (roleIds.cardinality() > PERM_ROLES_MAX)
+    {
+        throw USER_EXCEPTION(SCIDB_SE_OPERATOR, SCIDB_LE_ILLEGAL_OPERATION)
+            << "user has more than " << PERM_ROLES_MAX << " roles";
+    }
+    std::vector<Coordinate> result;
+    std::vector<PermissionIntervals::Interval> const& intervals = roleIds.intervals();
+    for (size_t i = 0; i < intervals.size(); i++)
+    {
+        for (Coordinate id = intervals[i].first; id <= intervals[i].second; id++)
+        {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+/**
+ * Read the permissions of roles from all instances, reading the role
+ * permissions array once and exchanging them in one round, and cache
+ * them. Must be called on all instances of the query.
+ * @param ids the roles, sorted and distinct.
+ * @return the permissions of each role, in the same order.
+ */
+static std::vector<PermissionIntervals> readRoles(RoleArrays const& roles,
+                                                  std::vector<Coordinate> const& ids,
+                                                  std::shared_ptr<Query>& query)
+{
+    if (ids.empty())
+    {
+        return std::vector<PermissionIntervals>();
+    }
+    PermissionsCache* cache = PermissionsCache::getInstance();
+    std::vector<PermissionIntervals> const roleIntervals = exchangePermissions(
+        readLocalPermissions(roles.grantsSchema, roles.grantsLayout, ids, query),
+        query);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        cache->put(ids[i],
+                   roles.grantsSchema.getUAId(),
+                   roles.grantsSchema.getVersionId(),
+                   roleIntervals[i]);
+    }
+    return roleIntervals;
+}
+
+std::vector<PermissionIntervals> readRolePermissions(RoleArrays const& roles,
+                                                     std::vector<Coordinate> const& userIds,
+                                                     std::shared_ptr<Query>& query)
+{
+    PermissionsCache* cache = PermissionsCache::getInstance();
+
+    // Every instance learns the same roles, so they all take part in
+    // the same exchanges
+    std::vector<PermissionIntervals> const roleIds = exchangePermissions(
+        readLocalPermissions(roles.membersSchema, roles.membersLayout, userIds, query),
+        query);
+    std::vector<std::vector<Coordinate> > userRoles(userIds.size());
+    std::vector<Coordinate> allIds;
+    for (size_t u = 0; u < userIds.size(); u++)
+    {
+        cache->put(userIds[u],
+                   roles.membersSchema.getUAId(),
+                   roles.membersSchema.getVersionId(),
+                   roleIds[u]);
+        userRoles[u] = listRoles(roleIds[u]);
+        allIds.insert(allIds.end(), userRoles[u].begin(), userRoles[u].end());
+    }
+    std::sort(allIds.begin(), allIds.end());
+    allIds.erase(std::unique(allIds.begin(), allIds.end()), allIds.end());
+    LOG4CXX_DEBUG(logger, "secure_scan::roles:" << allIds.size());
+
+    // The roles shared by several users are read once
+    std::vector<PermissionIntervals> const roleIntervals = readRoles(roles, allIds, query);
+    std::vector<PermissionIntervals> result(userIds.size());
+    for (size_t u = 0; u < userIds.size(); u++)
+    {
+        PermissionIntervals::Builder builder;
+        for (size_t i = 0; i < userRoles[u].size(); i++)
+        {
+            size_t const r = std::lower_bound(allIds.begin(), allIds.end(), userRoles[u][i]) -
+                allIds.begin();
+            builder.add(roleIntervals[r]);
+        }
+        result[u] = builder.finish();
+    }
+    return result;
+}
+
+PermissionIntervals readRolePermissions(RoleArrays const& roles,
+                                        Coordinate userId,
+                                        ResolvedRoles const* resolved,
+                                        std::shared_ptr<Query>& query)
+{
+    if (!resolved)
+    {
+        return readRolePermissions(roles, std::vector<Coordinate>(1, userId), query).front();
+    }
+
+    // Only the roles the coordinator did not find are read
+    LOG4CXX_DEBUG(logger, "secure_scan::roles resolved by coordinator, missing:"
+                  << resolved->missingIds.size());
+    std::vector<PermissionIntervals> const roleIntervals =
+        readRoles(roles, resolved->missingIds, query);
+    PermissionIntervals::Builder builder;
+    builder.add(resolved->intervals);
+    for (size_t i = 0; i < roleIntervals.size(); i++)
+    {
+        builder.add(roleIntervals[i]);
+    }
+    return builder.finish();
+}
+
+bool resolveRoles(RoleArrays const& roles,
+                  Coordinate userId,
+                  std::shared_ptr<Query> const& query,
+                  ResolvedRoles& resolved)
+{
+    PermissionsCache* cache = PermissionsCache::getInstance();
+
+    PermissionIntervals roleIds;
+    if (!cache->get(userId,
+                    roles.membersSchema.getUAId(),
+                    roles.membersSchema.getVersionId(),
+                    roleIds))
+    {
+        if (roles.membersSchema.getDistribution()->getDistType() != dtReplication)
+        {
+            return false;
+        }
+        roleIds = readLocalPermissions(roles.membersSchema, roles.membersLayout, userId, query);
+        cache->put(userId,
+                   roles.membersSchema.getUAId(),
+                   roles.membersSchema.getVersionId(),
+                   roleIds);
+    }
+    if (roleIds.cardinality() > PERM_ROLES_MAX)
+    {
+        return false;
+    }
+
+    // Each role is looked up in the cache, the others are read at once
+    // if the role permissions array is replicated, or left to the
+    // workers
+    PermissionIntervals::Builder builder;
+    std::vector<Coordinate> missingIds;
+    std::vector<Coordinate> const ids = listRoles(roleIds);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        PermissionIntervals roleIntervals;
+        if (cache->get(ids[i],
+                       roles.grantsSchema.getUAId(),
+                       roles.grantsSchema.getVersionId(),
+                       roleIntervals))
+        {
+            builder.add(roleIntervals);
+        }
+        else
+        {
+            missingIds.push_back(ids[i]);
+        }
+    }
+    if (!missingIds.empty() &&
+        roles.grantsSchema.getDistribution()->getDistType() == dtReplication)
+    {
+        std::vector<PermissionIntervals> const roleIntervals =
+            readLocalPermissions(roles.grantsSchema, roles.grantsLayout, missingIds, query);
+        for (size_t i = 0; i < missingIds.size(); i++)
+        {
+            cache->put(missingIds[i],
+                       roles.grantsSchema.getUAId(),
+                       roles.grantsSchema.getVersionId(),
+                       roleIntervals[i]);
+            builder.add(roleIntervals[i]);
+        }
+        missingIds.clear();
+    }
+    LOG4CXX_DEBUG(logger, "secure_scan::coordinator roles:" << ids.size()
+                  << " missing:" << missingIds.size());
+    resolved.intervals = builder.finish();
+    resolved.missingIds.swap(missingIds);
+    return true;
+}
+
+} //namespace scidb
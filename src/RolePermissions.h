@@ -0,0 +1,130 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file RolePermissions.h
+ *
+ * @brief Permissions granted to roles rather than to users.
+ *
+ * Next to a permissions array, e.g. PERM_NS.dataset_id, a role
+ * permissions array of the same name with ROLE_ARRAY_SUFFIX grants
+ * coordinates to roles, with a ROLE_DIM dimension instead of USER_DIM,
+ * in either layout of PermissionsLayout. The roles of each user are
+ * listed in PERM_NS.ROLE_MEMBERS_ARRAY, with a USER_DIM dimension and
+ * a ROLE_DIM dimension, or ranges of role IDs. A user may read the
+ * union of its own permissions and of the permissions of its roles.
+ *
+ * The roles of a user and the permissions of each role are cached
+ * separately in the PermissionsCache, keyed by user ID and role ID
+ * respectively. The coordinator looks up the roles of the user in its
+ * cache and ships them to the workers, which read and exchange only the
+ * roles it did not find, so the permissions of a role are read once
+ * for all its members.
+ */
+
+#ifndef ROLE_PERMISSIONS_H_
+#define ROLE_PERMISSIONS_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <array/Metadata.h>
+#include <query/Query.h>
+
+#include "PermissionIntervals.h"
+#include "Permissions.h"
+
+namespace scidb
+{
+
+/**
+ * The role arrays of a permission dimension.
+ */
+struct RoleArrays
+{
+    ArrayDesc         membersSchema;
+    PermissionsLayout membersLayout;
+    ArrayDesc         grantsSchema;
+    PermissionsLayout grantsLayout;
+};
+
+/**
+ * Look up the role arrays of a permission dimension, at their pinned
+ * versions if the coordinator pinned the versions, otherwise at their
+ * last versions.
+ * @param pinned the pinned versions, null if there are none.
+ * @return false if there is no role permissions array or no role
+ * members array, or they were not pinned.
+ * @throw if the arrays exist but cannot be used.
+ */
+bool findRoleArrays(std::shared_ptr<Query> const& query,
+                    std::string const& permDimName,
+                    std::vector<PinnedPermissions> const* pinned,
+                    RoleArrays& roles);
+
+/**
+ * Read the permissions of the roles of several users from all
+ * instances and cache them. The role members array and the role
+ * permissions array are each read once and exchanged in one round for
+ * all the users, and the roles shared by several users are read once.
+ * Must be called on all instances of the query.
+ * @param userIds the users, sorted and distinct.
+ * @return the union of the permissions of the roles of each user, in
+ * the same order.
+ */
+std::vector<PermissionIntervals> readRolePermissions(RoleArrays const& roles,
+                                                     std::vector<Coordinate> const& userIds,
+                                                     std::shared_ptr<Query>& query);
+
+/**
+ * Read the permissions of the roles of a user from all instances and
+ * cache them. Must be called on all instances of the query.
+ * @param resolved the roles resolved by the coordinator, if any. Only
+ *                 the roles it did not find are then read.
+ * @return the union of the permissions of the roles.
+ */
+PermissionIntervals readRolePermissions(RoleArrays const& roles,
+                                        Coordinate userId,
+                                        ResolvedRoles const* resolved,
+                                        std::shared_ptr<Query>& query);
+
+/**
+ * Resolve the roles of a user on this instance only: its roles and the
+ * permissions of each role are taken from the cache, or read from
+ * replicated arrays.
+ * @param[out] resolved set to the union of the permissions of the roles
+ *                      found and to the IDs of the others.
+ * @return false if the roles of the user cannot be listed on this
+ * instance.
+ */
+bool resolveRoles(RoleArrays const& roles,
+                  Coordinate userId,
+                  std::shared_ptr<Query> const& query,
+                  ResolvedRoles& resolved);
+
+} //namespace scidb
+
+#endif /* ROLE_PERMISSIONS_H_ */
@@ -0,0 +1,525 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include <algorithm>
+
+#include <log4cxx/logger.h>
+
+#include <array/MemArray.h>
+
+#include "settings.h"
+#include "SecureArray.h"
+
+using namespace std;
+
+namespace scidb
+{
+static log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("scidb.secure_scan"));
+
+//
+// SecureChunk
+//
+SecureChunk::SecureChunk(SecureArray const& array,
+                         DelegateArrayIterator const& iterator,
+                         AttributeID attrID)
+    : DelegateChunk(array, iterator, attrID, false)
+    , _array(array)
+    , _isCounted(false)
+{}
+
+void SecureChunk::setInputChunk(ConstChunk const& inputChunk)
+{
+    DelegateChunk::setInputChunk(inputChunk);
+    isClone = false;
+    _isCounted = false;
+
+    _mask.reset(_array.getPlan(),
+                inputChunk.getFirstPosition(false),
+                inputChunk.getFirstPosition(true),
+                inputChunk.getLastPosition(true));
+}
+
+namespace
+{
+    /**
+     * Test a cell against any mask.
+     */
+    struct MaskCheck
+    {
+        ChunkPlan::Mask const* mask;
+
+        bool operator()(Coordinates const& pos)
+        {
+            return mask->isPermitted(pos);
+        }
+    };
+
+    /**
+     * Test a cell against a mask along one dimension.
+     */
+    struct VectorCheck
+    {
+        size_t                   dimIdx;
+        Coordinate               origin;
+        std::vector<bool> const* mask;
+
+        bool operator()(Coordinates const& pos)
+        {
+            Coordinate const offset = pos[dimIdx] - origin;
+            return offset >= 0 &&
+                static_cast<size_t>(offset) < mask->size() &&
+                (*mask)[offset];
+        }
+    };
+
+    /**
+     * Test a cell against a bitmap along one dimension, starting from
+     * the container of the previous cell.
+     */
+    struct BitmapCheck
+    {
+        size_t                  dimIdx;
+        PermissionBitmap const* bitmap;
+        size_t                  hint;
+
+        bool operator()(Coordinates const& pos)
+        {
+            return bitmap->contains(pos[dimIdx], hint);
+        }
+    };
+}
+
+//
+// SecureChunkIterator
+//
+template <class Check>
+SecureChunkIterator<Check>::SecureChunkIterator(SecureChunk const& chunk,
+                                                int iterationMode,
+                                                Check const& check)
+    : DelegateChunkIterator(&chunk, iterationMode)
+    , _secureChunk(chunk)
+    , _check(check)
+{
+    skipDenied();
+}
+
+template <class Check>
+SecureChunkIterator<Check>::~SecureChunkIterator()
+{
+    if (!_secureChunk.isCounted())
+    {
+        _secureChunk.getSecureArray().record(_counts);
+    }
+}
+
+template <class Check>
+void SecureChunkIterator<Check>::skipDenied()
+{
+    while (!inputIterator->end() &&
+           !_check(inputIterator->getPosition()))
+    {
+        _counts.cellsFiltered++;
+        ++(*inputIterator);
+    }
+}
+
+template <class Check>
+bool SecureChunkIterator<Check>::end()
+{
+    return inputIterator->end();
+}
+
+template <class Check>
+void SecureChunkIterator<Check>::operator ++()
+{
+    ++(*inputIterator);
+    skipDenied();
+}
+
+template <class Check>
+bool SecureChunkIterator<Check>::setPosition(Coordinates const& pos)
+{
+    if (!_check(pos))
+    {
+        return false;
+    }
+    return inputIterator->setPosition(pos);
+}
+
+template <class Check>
+void SecureChunkIterator<Check>::restart()
+{
+    inputIterator->restart();
+    skipDenied();
+}
+
+std::shared_ptr<ConstChunkIterator> SecureChunk::getConstIterator(int iterationMode) const
+{
+    if (_mask.size() == 1)
+    {
+        ChunkPlan::Mask::DimensionMask const& mask = _mask[0];
+        if (mask.bitmap)
+        {
+            BitmapCheck const check = { mask.dimIdx, mask.bitmap, 0 };
+            return std::make_shared<SecureChunkIterator<BitmapCheck> >(*this, iterationMode, check);
+        }
+        VectorCheck const check = { mask.dimIdx, mask.origin, &mask.mask };
+        return std::make_shared<SecureChunkIterator<VectorCheck> >(*this, iterationMode, check);
+    }
+    MaskCheck const check = { &_mask };
+    return std::make_shared<SecureChunkIterator<MaskCheck> >(*this, iterationMode, check);
+}
+
+//
+// SecureArrayIterator
+//
+SecureArrayIterator::SecureArrayIterator(SecureArray const& array,
+                                         const AttributeDesc& attrID,
+                                         const AttributeDesc& inputAttrID)
+    : DelegateArrayIterator(array, attrID, array.getPipe(0)->getConstIterator(inputAttrID))
+    , _array(array)
+    , _attr(attrID)
+    , _isInputAttr(attrID.getId() == inputAttrID.getId())
+    , _kind(ChunkPlan::SKIP)
+    , _chunkIdx(0)
+{
+    if (_array.getChunks())
+    {
+        skipMissing();
+    }
+    else
+    {
+        skipDenied();
+    }
+}
+
+SecureArrayIterator::~SecureArrayIterator()
+{
+    _array.record(_counts);
+}
+
+void SecureArrayIterator::probe(Coordinates const& chunkPos)
+{
+    _materialized.reset();
+    _materializedIterator.reset();
+    _kind = _array.getPlan().getKind(chunkPos, _hints);
+    _counts.chunksProbed++;
+    switch (_kind)
+    {
+    case ChunkPlan::SKIP:
+        _counts.chunksSkipped++;
+        break;
+    case ChunkPlan::PASS_THROUGH:
+        _counts.chunksPassed++;
+        break;
+    case ChunkPlan::MASKED:
+        _counts.chunksMasked++;
+        break;
+    }
+}
+
+void SecureArrayIterator::skipMissing()
+{
+    chunkInitialized = false;
+    std::vector<Coordinates> const& chunks = *_array.getChunks();
+    for (; _chunkIdx < chunks.size(); _chunkIdx++)
+    {
+        if (inputIterator->setPosition(chunks[_chunkIdx]))
+        {
+            _array.advance(_chunkIdx);
+            probe(chunks[_chunkIdx]);
+            return;
+        }
+    }
+}
+
+void SecureArrayIterator::skipDenied()
+{
+    chunkInitialized = false;
+    while (!inputIterator->end())
+    {
+        probe(inputIterator->getPosition());
+        if (_kind != ChunkPlan::SKIP)
+        {
+            return;
+        }
+        ++(*inputIterator);
+    }
+}
+
+ConstChunk const& SecureArrayIterator::getChunk()
+{
+    if (_kind == ChunkPlan::PASS_THROUGH && _isInputAttr)
+    {
+        // Every cell of the stored chunk is permitted
+        return inputIterator->getChunk();
+    }
+    if (_kind == ChunkPlan::MASKED && _array.isMaterializing())
+    {
+        if (!_materializedIterator)
+        {
+            Coordinates const& chunkPos = inputIterator->getPosition();
+            DelegateArrayIterator::getChunk();
+            SecureChunk& secureChunk = static_cast<SecureChunk&>(*chunk);
+            _materialized = _array.materialize(chunkPos, _attr, secureChunk);
+            if (!_materialized)
+            {
+                return secureChunk;
+            }
+            _materializedIterator = _materialized->getConstIterator(_attr);
+            if (!_materializedIterator->setPosition(chunkPos))
+            {
+                // No permitted cell in the chunk, whose denied cells
+                // were counted by the copy
+                _materializedIterator.reset();
+                if (!_attr.isEmptyIndicator())
+                {
+                    secureChunk.setCounted();
+                }
+                return secureChunk;
+            }
+        }
+        return _materializedIterator->getChunk();
+    }
+    return DelegateArrayIterator::getChunk();
+}
+
+bool SecureArrayIterator::end()
+{
+    if (_array.getChunks())
+    {
+        return _chunkIdx >= _array.getChunks()->size();
+    }
+    return inputIterator->end();
+}
+
+void SecureArrayIterator::operator ++()
+{
+    if (_array.getChunks())
+    {
+        _chunkIdx++;
+        skipMissing();
+        return;
+    }
+    ++(*inputIterator);
+    skipDenied();
+}
+
+bool SecureArrayIterator::setPosition(Coordinates const& pos)
+{
+    chunkInitialized = false;
+    Coordinates chunkPos = pos;
+    _array.getArrayDesc().getChunkPositionFor(chunkPos);
+    probe(chunkPos);
+    if (_kind == ChunkPlan::SKIP)
+    {
+        return false;
+    }
+    if (_array.getChunks())
+    {
+        // Resume from the listed position, if it is listed
+        std::vector<Coordinates> const& chunks = *_array.getChunks();
+        std::vector<Coordinates>::const_iterator it =
+            std::lower_bound(chunks.begin(), chunks.end(), chunkPos);
+        if (it == chunks.end() || *it != chunkPos)
+        {
+            return false;
+        }
+        _chunkIdx = it - chunks.begin();
+        _array.advance(_chunkIdx);
+    }
+    return inputIterator->setPosition(pos);
+}
+
+void SecureArrayIterator::restart()
+{
+    _hints.clear();
+    if (_array.getChunks())
+    {
+        _chunkIdx = 0;
+        skipMissing();
+        return;
+    }
+    inputIterator->restart();
+    skipDenied();
+}
+
+//
+// SecureArray
+//
+SecureArray::SecureArray(ArrayDesc const& desc,
+                         std::shared_ptr<ChunkPlan> const& plan,
+                         std::shared_ptr<Array> const& input,
+                         Coordinate userId,
+                         SecureScanStats::Counters const& counters,
+                         std::shared_ptr<std::vector<Coordinates> const> const& chunks,
+                         std::shared_ptr<Query> const& query)
+    : DelegateArray(desc, input)
+    , _plan(plan)
+    , _userId(userId)
+    , _chunks(chunks)
+    , _query(query)
+    , _isMaterializing(MASKED_CHUNK_CACHE_SIZE > 0 && desc.getEmptyBitmapAttribute() != NULL)
+    , _counters(counters)
+    , _prefetchStream(0)
+{
+    // The output may only have some of the attributes of the input
+    for (auto const& attr : desc.getAttributes())
+    {
+        AttributeDesc const* inputAttr = NULL;
+        if (attr.isEmptyIndicator())
+        {
+            inputAttr = input->getArrayDesc().getEmptyBitmapAttribute();
+        }
+        else
+        {
+            for (auto const& candidate : input->getArrayDesc().getAttributes(true))
+            {
+                if (candidate.getName() == attr.getName())
+                {
+                    inputAttr = &candidate;
+                    break;
+                }
+            }
+        }
+        SCIDB_ASSERT(inputAttr);
+        SCIDB_ASSERT(attr.getId() == _inputAttrs.size());
+        _inputAttrs.push_back(*inputAttr);
+    }
+
+    if (PREFETCH_CHUNKS > 0 && _chunks && _chunks->size() > 1)
+    {
+        _prefetchStream = ChunkPrefetcher::getInstance()->addStream(input, _inputAttrs, _chunks);
+    }
+}
+
+SecureArray::~SecureArray()
+{
+    if (_prefetchStream)
+    {
+        ChunkPrefetcher::getInstance()->removeStream(_prefetchStream);
+    }
+    if (_counters.queries > 0)
+    {
+        SecureScanStats::getInstance()->add(_userId, _counters);
+    }
+}
+
+void SecureArray::record(SecureScanStats::Counters const& counts) const
+{
+    std::lock_guard<std::mutex> lock(_countersMutex);
+    _counters += counts;
+}
+
+std::shared_ptr<Array> SecureArray::materialize(Coordinates const& chunkPos,
+                                                AttributeDesc const& attr,
+                                                SecureChunk const& chunk) const
+{
+    // Copy under the lock, so that the iterators of the same attribute
+    // wait for the copy instead of making their own
+    std::lock_guard<std::mutex> lock(_materializedMutex);
+    auto it = _materialized.begin();
+    while (it != _materialized.end() && it->chunkPos != chunkPos)
+    {
+        ++it;
+    }
+    if (it != _materialized.end())
+    {
+        _materialized.splice(_materialized.begin(), _materialized, it);
+    }
+    else
+    {
+        if (attr.isEmptyIndicator())
+        {
+            return std::shared_ptr<Array>();
+        }
+        std::shared_ptr<Query> query(Query::getValidQueryPtr(_query));
+        Materialized materialized;
+        materialized.chunkPos = chunkPos;
+        materialized.copy = std::make_shared<MemArray>(getArrayDesc(), query);
+        materialized.isCopied.resize(getArrayDesc().getAttributes().size(), false);
+        materialized.isWritten = false;
+        _materialized.push_front(materialized);
+        if (_materialized.size() > MASKED_CHUNK_CACHE_SIZE)
+        {
+            _materialized.pop_back();
+        }
+    }
+
+    Materialized& materialized = _materialized.front();
+    if (!attr.isEmptyIndicator() && !materialized.isCopied[attr.getId()])
+    {
+        copyPermitted(attr, chunk, materialized);
+    }
+    return materialized.copy;
+}
+
+void SecureArray::copyPermitted(AttributeDesc const& attr,
+                                SecureChunk const& chunk,
+                                Materialized& materialized) const
+{
+    std::shared_ptr<Query> query(Query::getValidQueryPtr(_query));
+
+    // The cells are in the same order for every attribute: the first
+    // attribute copied writes the empty bitmap for the others
+    shared_ptr<ArrayIterator> oaiter = materialized.copy->getIterator(attr);
+    shared_ptr<ChunkIterator> ociter =
+        oaiter->newChunk(materialized.chunkPos).getIterator(query,
+                                                            materialized.isWritten
+                                                            ? ChunkIterator::SEQUENTIAL_WRITE |
+                                                              ChunkIterator::NO_EMPTY_CHECK
+                                                            : ChunkIterator::SEQUENTIAL_WRITE);
+
+    // The iterator of the secure chunk skips and counts the denied cells
+    size_t cells = 0;
+    {
+        shared_ptr<ConstChunkIterator> citer = chunk.getConstIterator(0);
+        for (; !citer->end(); ++(*citer))
+        {
+            if (ociter->setPosition(citer->getPosition()))
+            {
+                ociter->writeItem(citer->getItem());
+                cells++;
+            }
+        }
+    }
+    ociter->flush();
+    materialized.isCopied[attr.getId()] = true;
+    materialized.isWritten = true;
+    LOG4CXX_TRACE(logger, "secure_scan::materialized " << attr.getName()
+                  << " cells:" << cells);
+}
+
+DelegateArrayIterator* SecureArray::createArrayIterator(const AttributeDesc& attrID) const
+{
+    return new SecureArrayIterator(*this, attrID, getInputAttribute(attrID));
+}
+
+DelegateChunk* SecureArray::createChunk(DelegateArrayIterator const* iterator, AttributeID attrID) const
+{
+    return new SecureChunk(*this, *iterator, attrID);
+}
+
+} //namespace scidb
@@ -0,0 +1,318 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file SecureArray.h
+ *
+ * @brief The array returned by secure_scan to users without read
+ * permission on the namespace.
+ *
+ * The array iterator walks the chunks of the input array and asks the
+ * chunk plan what to do with each of them. Skipped chunks are never
+ * read. Pass-through chunks are returned as the stored chunk, without
+ * any delegate wrapping. Masked chunks are wrapped in a SecureChunk,
+ * which builds the mask of the permitted coordinates along the
+ * permission dimension once, when the input chunk is set, and whose
+ * iterators skip the cells outside of the mask. When the plan keeps the
+ * permissions as a bitmap, cells are tested against the bitmap instead.
+ * With several permission dimensions, a cell must be permitted along
+ * all of them.
+ *
+ * Masked chunks may instead be materialized: the permitted cells of an
+ * attribute are copied into a MemArray the first time the attribute is
+ * read at a chunk position, so that downstream operators read plain
+ * stored chunks. The copies are kept for the few most recent chunk
+ * positions and shared by the iterators of all attributes.
+ *
+ * When the array is given the list of the chunks this instance may
+ * hold, the array iterator visits the positions of the list instead of
+ * walking every local chunk, and registers the list with the
+ * ChunkPrefetcher of the instance, which reads the chunks of the next
+ * positions of the list ahead of the iterators.
+ *
+ * The array may return only some of the attributes of the input, read
+ * by name. Only the chunks of those attributes are then read.
+ *
+ * Iterators count the chunks and cells they visit and add their counts
+ * to the array when destroyed, and the array adds them to the
+ * statistics of the user when destroyed.
+ */
+
+#ifndef SECURE_ARRAY_H_
+#define SECURE_ARRAY_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <array/DelegateArray.h>
+
+#include "ChunkPlan.h"
+#include "ChunkPrefetcher.h"
+#include "SecureScanStats.h"
+
+namespace scidb
+{
+
+class SecureArray;
+
+class SecureChunk : public DelegateChunk
+{
+public:
+    SecureChunk(SecureArray const& array, DelegateArrayIterator const& iterator, AttributeID attrID);
+
+    void setInputChunk(ConstChunk const& inputChunk) override;
+    std::shared_ptr<ConstChunkIterator> getConstIterator(int iterationMode) const override;
+
+    SecureArray const& getSecureArray() const
+    {
+        return _array;
+    }
+
+    /**
+     * Record that the denied cells of the chunk were already counted,
+     * so that its iterators do not count them again.
+     */
+    void setCounted()
+    {
+        _isCounted = true;
+    }
+
+    bool isCounted() const
+    {
+        return _isCounted;
+    }
+
+private:
+    SecureArray const& _array;
+    ChunkPlan::Mask    _mask;
+    bool               _isCounted;
+};
+
+/**
+ * Iterates over the permitted cells of a SecureChunk. The test of a
+ * cell is a template parameter, instantiated in SecureArray.cpp, so
+ * that a mask along a single permission dimension, the usual case, is
+ * tested inline without looping over the dimensions of the mask.
+ */
+template <class Check>
+class SecureChunkIterator : public DelegateChunkIterator
+{
+public:
+    SecureChunkIterator(SecureChunk const& chunk, int iterationMode, Check const& check);
+    ~SecureChunkIterator();
+
+    bool end() override;
+    void operator ++() override;
+    bool setPosition(Coordinates const& pos) override;
+    void restart() override;
+
+private:
+    /**
+     * Advance the input iterator to the next permitted cell.
+     */
+    void skipDenied();
+
+    SecureChunk const&        _secureChunk;
+    Check                     _check;
+    SecureScanStats::Counters _counts;
+};
+
+class SecureArrayIterator : public DelegateArrayIterator
+{
+public:
+    SecureArrayIterator(SecureArray const& array,
+                        const AttributeDesc& attrID,
+                        const AttributeDesc& inputAttrID);
+    ~SecureArrayIterator();
+
+    ConstChunk const& getChunk() override;
+    bool end() override;
+    void operator ++() override;
+    bool setPosition(Coordinates const& pos) override;
+    void restart() override;
+
+private:
+    /**
+     * Advance the input iterator to the next chunk that is not
+     * skipped by the chunk plan.
+     */
+    void skipDenied();
+
+    /**
+     * Advance the input iterator to the next listed chunk that is
+     * stored.
+     */
+    void skipMissing();
+
+    /**
+     * Look up a chunk in the chunk plan and count it.
+     */
+    void probe(Coordinates const& chunkPos);
+
+    SecureArray const&        _array;
+    AttributeDesc             _attr;
+    bool                      _isInputAttr;  // the attribute has the same ID in the input
+    ChunkPlan::Kind           _kind;
+    SecureScanStats::Counters _counts;
+
+    /**
+     * The materialized chunks of the current masked chunk, if any, and
+     * the iterator positioned on the chunk of this attribute.
+     */
+    std::shared_ptr<Array>             _materialized;
+    std::shared_ptr<ConstArrayIterator> _materializedIterator;
+
+    /**
+     * The position in the chunk list of the array, if any.
+     */
+    size_t _chunkIdx;
+
+    /**
+     * @see ChunkPlan::getKind
+     */
+    std::vector<size_t> _hints;
+};
+
+class SecureArray : public DelegateArray
+{
+public:
+    /**
+     * @param desc the output schema, with the attributes of the input
+     *             to return.
+     * @param userId the user the statistics are recorded for.
+     * @param counters the counters of the setup of the scan, not
+     *                 recorded if they count no query.
+     * @param chunks the positions of the chunks to visit, in row-major
+     *               order, null to walk every local chunk.
+     */
+    SecureArray(ArrayDesc const& desc,
+                std::shared_ptr<ChunkPlan> const& plan,
+                std::shared_ptr<Array> const& input,
+                Coordinate userId,
+                SecureScanStats::Counters const& counters,
+                std::shared_ptr<std::vector<Coordinates> const> const& chunks,
+                std::shared_ptr<Query> const& query);
+    ~SecureArray();
+
+    DelegateArrayIterator* createArrayIterator(const AttributeDesc& attrID) const override;
+    DelegateChunk* createChunk(DelegateArrayIterator const* iterator, AttributeID attrID) const override;
+
+    ChunkPlan const& getPlan() const
+    {
+        return *_plan;
+    }
+
+    std::vector<Coordinates> const* getChunks() const
+    {
+        return _chunks.get();
+    }
+
+    /**
+     * @return the attribute of the input an attribute is read from.
+     */
+    AttributeDesc const& getInputAttribute(AttributeDesc const& attr) const
+    {
+        return _inputAttrs[attr.getId()];
+    }
+
+    /**
+     * Add the counts of an iterator to the counters of the scan.
+     */
+    void record(SecureScanStats::Counters const& counts) const;
+
+    /**
+     * @return true if masked chunks are materialized rather than
+     * filtered cell by cell.
+     */
+    bool isMaterializing() const
+    {
+        return _isMaterializing;
+    }
+
+    /**
+     * @return an array holding the permitted cells of an attribute at
+     * the position of a masked chunk of the input, copied from the
+     * chunk on the first call for the attribute and shared by later
+     * calls while the position is among the MASKED_CHUNK_CACHE_SIZE
+     * most recent ones. The empty bitmap is not copied on its own: null
+     * if no other attribute was copied at the position.
+     */
+    std::shared_ptr<Array> materialize(Coordinates const& chunkPos,
+                                       AttributeDesc const& attr,
+                                       SecureChunk const& chunk) const;
+
+    /**
+     * Record that an iterator reached a position of the chunk list.
+     */
+    void advance(size_t chunkIdx) const
+    {
+        if (_prefetchStream)
+        {
+            ChunkPrefetcher::getInstance()->advance(_prefetchStream, chunkIdx);
+        }
+    }
+
+private:
+    /**
+     * The copies of the attributes read at a masked chunk position.
+     */
+    struct Materialized
+    {
+        Coordinates            chunkPos;
+        std::shared_ptr<Array> copy;
+        std::vector<bool>      isCopied;  // by attribute ID
+        bool                   isWritten; // the empty bitmap is written
+    };
+
+    /**
+     * Copy the permitted cells of an attribute, read through the
+     * iterators of its secure chunk.
+     */
+    void copyPermitted(AttributeDesc const& attr,
+                       SecureChunk const& chunk,
+                       Materialized& materialized) const;
+
+    std::shared_ptr<ChunkPlan> _plan;
+    Coordinate                 _userId;
+    std::shared_ptr<std::vector<Coordinates> const> _chunks;
+    std::vector<AttributeDesc> _inputAttrs;  // by output attribute ID
+    std::weak_ptr<Query>       _query;
+    bool                       _isMaterializing;
+
+    // Most recently materialized first
+    mutable std::mutex _materializedMutex;
+    mutable std::list<Materialized> _materialized;
+
+    mutable std::mutex                _countersMutex;
+    mutable SecureScanStats::Counters _counters;
+
+    size_t _prefetchStream;  // 0 if the chunks are not read ahead
+};
+
+} //namespace scidb
+
+#endif /* SECURE_ARRAY_H_ */
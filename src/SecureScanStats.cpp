@@ -0,0 +1,116 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+#include "SecureScanStats.h"
+
+using namespace std;
+
+namespace scidb
+{
+
+SecureScanStats::Counters::Counters()
+    : queries(0),
+      catalogUsec(0),
+      readUsec(0),
+      exchangeUsec(0),
+      permittedCells(0),
+      ranges(0),
+      chunksProbed(0),
+      chunksSkipped(0),
+      chunksPassed(0),
+      chunksMasked(0),
+      cellsFiltered(0)
+{}
+
+SecureScanStats::Counters& SecureScanStats::Counters::operator+=(Counters const& other)
+{
+    queries += other.queries;
+    catalogUsec += other.catalogUsec;
+    readUsec += other.readUsec;
+    exchangeUsec += other.exchangeUsec;
+    permittedCells += other.permittedCells;
+    ranges += other.ranges;
+    chunksProbed += other.chunksProbed;
+    chunksSkipped += other.chunksSkipped;
+    chunksPassed += other.chunksPassed;
+    chunksMasked += other.chunksMasked;
+    cellsFiltered += other.cellsFiltered;
+    return *this;
+}
+
+std::vector<std::string> const& SecureScanStats::Counters::getNames()
+{
+    static std::vector<std::string> const names {
+        "queries",
+        "catalog_usec",
+        "read_usec",
+        "exchange_usec",
+        "permitted_cells",
+        "ranges",
+        "chunks_probed",
+        "chunks_skipped",
+        "chunks_passed",
+        "chunks_masked",
+        "cells_filtered"
+    };
+    return names;
+}
+
+std::vector<uint64_t> SecureScanStats::Counters::getValues() const
+{
+    return std::vector<uint64_t> {
+        queries,
+        catalogUsec,
+        readUsec,
+        exchangeUsec,
+        permittedCells,
+        ranges,
+        chunksProbed,
+        chunksSkipped,
+        chunksPassed,
+        chunksMasked,
+        cellsFiltered
+    };
+}
+
+SecureScanStats* SecureScanStats::getInstance()
+{
+    static SecureScanStats instance;
+    return &instance;
+}
+
+void SecureScanStats::add(Coordinate userId, Counters const& counters)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _users[userId] += counters;
+}
+
+SecureScanStats::UserCounters SecureScanStats::get()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _users;
+}
+
+} //namespace scidb
@@ -0,0 +1,124 @@
+/*
+**
+* BEGIN_COPYRIGHT
+*
+* Copyright (C) 2008-2017 SciDB, Inc.
+* All Rights Reserved.
+*
+* secure_scan is a plugin for SciDB, an Open Source Array DBMS maintained
+* by Paradigm4. See http://www.paradigm4.com/
+*
+* secure_scan is free software: you can redistribute it and/or modify
+* it under the terms of the AFFERO GNU General Public License as published by
+* the Free Software Foundation.
+*
+* secure_scan is distributed "AS-IS" AND WITHOUT ANY WARRANTY OF ANY KIND,
+* INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY,
+* NON-INFRINGEMENT, OR FITNESS FOR A PARTICULAR PURPOSE. See
+* the AFFERO GNU General Public License for the complete license terms.
+*
+* You should have received a copy of the AFFERO GNU General Public License
+* along with secure_scan.  If not, see <http://www.gnu.org/licenses/agpl-3.0.html>
+*
+* END_COPYRIGHT
+*/
+
+/**
+ * @file SecureScanStats.h
+ *
+ * @brief Per-instance runtime statistics of secure_scan, aggregated by
+ * user and read with the secure_scan_stats() operator.
+ *
+ * Each restricted secure_scan fills its own counters: the setup phases
+ * in execute, the chunks and cells as the returned array is read. The
+ * counters are added to the statistics of the user when the returned
+ * array is destroyed.
+ */
+
+#ifndef SECURE_SCAN_STATS_H_
+#define SECURE_SCAN_STATS_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <array/Metadata.h>
+
+namespace scidb
+{
+
+class SecureScanStats
+{
+public:
+    struct Counters
+    {
+        uint64_t queries;         // counted once on every instance a query runs on
+        uint64_t catalogUsec;     // permissions array catalog lookups
+        uint64_t readUsec;        // local permission slice reads
+        uint64_t exchangeUsec;    // permission exchange between instances
+        uint64_t permittedCells;  // permitted coordinates, over all permission dimensions
+        uint64_t ranges;          // collapsed intervals, over all permission dimensions
+        uint64_t chunksProbed;    // data chunks looked up in the chunk plan, over all attributes
+        uint64_t chunksSkipped;
+        uint64_t chunksPassed;    // returned as stored, every cell permitted
+        uint64_t chunksMasked;    // returned with some cells filtered out
+        uint64_t cellsFiltered;   // denied cells skipped, over all attributes
+
+        Counters();
+        Counters& operator+=(Counters const& other);
+
+        /**
+         * @return the names of the counters, as attributes of the
+         * secure_scan_stats() output, in the order of getValues.
+         */
+        static std::vector<std::string> const& getNames();
+        std::vector<uint64_t> getValues() const;
+    };
+
+    typedef std::map<Coordinate, Counters> UserCounters;
+
+    /**
+     * Adds the elapsed time since its construction to a counter when
+     * it goes out of scope.
+     */
+    class Timer
+    {
+    public:
+        explicit Timer(uint64_t& usec)
+            : _usec(usec),
+              _start(std::chrono::steady_clock::now())
+        {}
+
+        ~Timer()
+        {
+            _usec += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - _start).count();
+        }
+
+    private:
+        uint64_t& _usec;
+        std::chrono::steady_clock::time_point const _start;
+    };
+
+    static SecureScanStats* getInstance();
+
+    void add(Coordinate userId, Counters const& counters);
+
+    /**
+     * @return a copy of the counters of every user.
+     */
+    UserCounters get();
+
+private:
+    SecureScanStats()
+    {}
+
+    std::mutex   _mutex;
+    UserCounters _users;
+};
+
+} //namespace scidb
+
+#endif /* SECURE_SCAN_STATS_H_ */
@@ -0,0 +1,165 @@
+#!/bin/bash
+
+# Benchmark secure_scan against scan and between on a local SciDB.
+#
+# The permissions array holds the grants of BENCH_USERS users, one of
+# them being the bench login user, each granted BENCH_GRANTS datasets in
+# runs of BENCH_RUN consecutive datasets (BENCH_RUN=1 is the most
+# fragmented). The data array has BENCH_DATASETS datasets in chunks of
+# BENCH_CHUNK along dataset_id, and BENCH_DIMS - 1 more dimensions of
+# BENCH_EXTENT cells each, in one chunk.
+#
+# Every query is run BENCH_REPEAT times through iquery and the results
+# are printed as CSV, one line per run. Times include the iquery client.
+#
+# Uses the permissions namespace of the plugin: do not run on a
+# production database. Pass "debug" to keep the arrays.
+
+BENCH_USERS=${BENCH_USERS:-100}
+BENCH_GRANTS=${BENCH_GRANTS:-1000}
+BENCH_RUN=${BENCH_RUN:-10}
+BENCH_DATASETS=${BENCH_DATASETS:-100000}
+BENCH_CHUNK=${BENCH_CHUNK:-1000}
+BENCH_DIMS=${BENCH_DIMS:-2}
+BENCH_EXTENT=${BENCH_EXTENT:-10}
+BENCH_REPEAT=${BENCH_REPEAT:-5}
+
+NS_SEC=bench_secured
+NS_PER=permissions
+DAT=bench
+DIM=dataset_id
+FLAG=access
+
+
+set -o errexit
+
+function cleanup {
+    echo "--- entering cleanup" >&2
+    iquery -A auth_admin -anq "remove($NS_SEC.$DAT)"      || true
+    iquery -A auth_admin -anq "drop_namespace('$NS_SEC')" || true
+
+    iquery -A auth_admin -anq "remove($NS_PER.$DIM)"      || true
+
+    iquery -A auth_admin -anq "drop_user('bench')"        || true
+
+    rm auth_admin \
+       auth_bench
+}
+
+if (( BENCH_GRANTS % BENCH_RUN != 0 ||
+      BENCH_DATASETS * BENCH_RUN % BENCH_GRANTS != 0 ||
+      BENCH_GRANTS > BENCH_DATASETS ))
+then
+    echo "BENCH_GRANTS must be a multiple of BENCH_RUN, no more than" \
+         "BENCH_DATASETS, and divide BENCH_DATASETS * BENCH_RUN" >&2
+    exit 1
+fi
+
+
+echo "1. Auth" >&2
+cat <<EOF > auth_admin
+[security_password]
+user-name=scidbadmin
+user-password=Paradigm4
+EOF
+chmod 0600 auth_admin
+
+# Never touch an existing permissions array
+if iquery -A auth_admin -aq "show($NS_PER.$DIM)" > /dev/null 2>&1
+then
+    echo "$NS_PER.$DIM already exists" >&2
+    rm auth_admin
+    exit 1
+fi
+
+if [ "$1" != "debug" ]
+then
+    trap cleanup EXIT
+fi
+
+cat <<EOF > auth_bench
+[security_password]
+user-name=bench
+user-password=benchsecret
+EOF
+chmod 0600 auth_bench
+PWHASH=$(echo -n "benchsecret" | openssl dgst -sha512 -binary | base64 --wrap 0)
+iquery -A auth_admin -aq "load_library('secure_scan')" > /dev/null 2>&1 || true
+iquery -A auth_admin -anq "create_user('bench', '"$PWHASH"')"
+USER_ID=$(iquery -A auth_admin -o csv -aq "
+    project(filter(list('users'), name='bench'), id)")
+
+
+echo "2. Namespaces" >&2
+iquery -A auth_admin -anq "create_namespace('$NS_SEC')"
+iquery -A auth_admin -anq "create_namespace('$NS_PER')" > /dev/null 2>&1 || true
+iquery -A auth_admin -anq "
+    set_role_permissions('bench', 'namespace', '$NS_SEC', 'l')"
+
+
+echo "3. Permissions array" >&2
+# Each user gets BENCH_GRANTS / BENCH_RUN runs of BENCH_RUN datasets,
+# spread evenly and shifted by user
+STRIDE=$(( BENCH_DATASETS * BENCH_RUN / BENCH_GRANTS ))
+FIRST_USER=$(( USER_ID - BENCH_USERS / 2 ))
+if (( FIRST_USER < 0 ))
+then
+    FIRST_USER=0
+fi
+LAST_USER=$(( FIRST_USER + BENCH_USERS - 1 ))
+iquery -A auth_admin -anq "
+    create array $NS_PER.$DIM
+    <$FLAG:bool>[user_id=0:*:0:1; $DIM=0:$(( BENCH_DATASETS - 1 )):0:$BENCH_CHUNK]"
+iquery -A auth_admin -anq "
+    store(
+        filter(
+            build(<$FLAG:bool>[user_id=$FIRST_USER:$LAST_USER:0:1;
+                               $DIM=0:$(( BENCH_DATASETS - 1 )):0:$BENCH_CHUNK],
+                  true),
+            ($DIM + user_id * $BENCH_RUN) % $STRIDE < $BENCH_RUN),
+        $NS_PER.$DIM)"
+
+
+echo "4. Data array" >&2
+SCHEMA="$DIM=0:$(( BENCH_DATASETS - 1 )):0:$BENCH_CHUNK"
+EXTRA_LOW=""
+EXTRA_HIGH=""
+for (( d = 1; d < BENCH_DIMS; d++ ))
+do
+    SCHEMA="$SCHEMA; d$d=0:$(( BENCH_EXTENT - 1 )):0:$BENCH_EXTENT"
+    EXTRA_LOW="$EXTRA_LOW, 0"
+    EXTRA_HIGH="$EXTRA_HIGH, $(( BENCH_EXTENT - 1 ))"
+done
+iquery -A auth_admin -anq "
+    store(build(<val:double>[$SCHEMA], random()), $NS_SEC.$DAT)"
+
+# The span of the permissions of the bench user, for between
+RANGE=$(iquery -A auth_admin -o csv -aq "
+    aggregate(
+        filter($NS_PER.$DIM, user_id = $USER_ID),
+        min($DIM), max($DIM))")
+LOW="${RANGE%%,*}$EXTRA_LOW"
+HIGH="${RANGE##*,}$EXTRA_HIGH"
+
+
+echo "5. Queries" >&2
+function bench {
+    local name=$1
+    local auth=$2
+    local query=$3
+    for (( r = 1; r <= BENCH_REPEAT; r++ ))
+    do
+        local start=$(date +%s%N)
+        local cells=$(iquery -A $auth -o csv -aq "op_count($query)")
+        local end=$(date +%s%N)
+        local seconds=$(echo "scale=6; ($end - $start) / 1000000000" | bc)
+        local rate=$(echo "scale=0; $cells / $seconds" | bc)
+        echo "$name,$BENCH_USERS,$BENCH_GRANTS,$BENCH_RUN,$BENCH_DATASETS,$BENCH_CHUNK,$BENCH_DIMS,$BENCH_EXTENT,$r,$seconds,$cells,$rate"
+    done
+}
+
+echo "query,users,grants,run,datasets,chunk,dims,extent,repeat,seconds,cells,cells_per_sec"
+bench scan             auth_admin "scan($NS_SEC.$DAT)"
+bench between          auth_admin "between($NS_SEC.$DAT, $LOW, $HIGH)"
+bench secure_scan_dba  auth_admin "secure_scan($NS_SEC.$DAT)"
+bench secure_scan      auth_bench "secure_scan($NS_SEC.$DAT)"
@@ -28,3 +28,80 @@
 #define USER_DIM   "user_id"
 #define PERM_DIM   "dataset_id"
 #define READ_PERM  "read"
+
+// Maximum number of permission intervals cached on each instance, over
+// all the users and roles, each entry counting for one more
+#define PERM_CACHE_MAX_INTERVALS (1 << 20)
+
+// Control cookie tag for the permissions array versions pinned and the
+// permissions resolved by the coordinator
+#define RESOLVED_PERM "resolved"
+
+// Largest size of the control cookie, in bytes: above it the coordinator
+// ships only the pinned versions, and the workers read the permissions
+#define PERM_COOKIE_MAX_BYTES (64 * 1024)
+
+// Permissions with at least this many intervals, and no more than this
+// many coordinates per interval on average, are kept as a bitmap
+#define PERM_BITMAP_MIN_INTERVALS 1024
+#define PERM_BITMAP_MAX_AVG_RUN   4
+
+// Size of the Bloom filter in front of a permissions bitmap, in bits per
+// permitted coordinate, 0 to disable it, and the largest number of
+// permitted coordinates of a filtered bitmap
+#define PERM_BLOOM_BITS_PER_VALUE 16
+#define PERM_BLOOM_MAX_VALUES     (1 << 22)
+
+// Attributes of a permissions array that stores one range of permitted
+// coordinates per grant, both ends included, instead of one cell per
+// permitted coordinate
+#define PERM_RANGE_LOW  "low"
+#define PERM_RANGE_HIGH "high"
+
+// Permissions granted to roles: the role permissions array of a
+// permissions array has its name with ROLE_ARRAY_SUFFIX and a ROLE_DIM
+// dimension instead of USER_DIM, and ROLE_MEMBERS_ARRAY lists the roles
+// of each user along ROLE_DIM. A user may have up to PERM_ROLES_MAX roles.
+#define ROLE_DIM           "role_id"
+#define ROLE_ARRAY_SUFFIX  "_role"
+#define ROLE_MEMBERS_ARRAY "role_members"
+#define PERM_ROLES_MAX     1024
+
+// secure_scan_users materializes the output of all its users on each
+// instance, so it accepts up to PERM_SCAN_USERS_MAX user IDs
+#define PERM_SCAN_USERS_MAX 64
+
+// Permission dimensions enforced in addition to PERM_DIM, each with the
+// permissions array of the same name in PERM_NS. A dimension is only
+// enforced if both the scanned array and the permissions array have it.
+#define PERM_EXTRA_DIMS { "dataset_version" }
+
+// Chunk interval of the user dimension of the secure_scan_stats() output
+#define STATS_USER_CHUNK 1000000
+
+// Chunk interval of the entry dimension of the secure_scan explain output
+#define EXPLAIN_ENTRY_CHUNK 1000000
+
+// Maximum number of permitted chunks listed to locate the ones stored on
+// each instance of a hash-partitioned array; above it, every local chunk
+// is walked
+#define PERM_CHUNK_LIST_MAX 65536
+
+// Number of data array versions whose local chunks are indexed on each
+// instance, 0 to disable the index, and the largest number of local
+// chunks indexed on each instance, over all the indexed versions
+#define CHUNK_INDEX_SIZE       64
+#define CHUNK_INDEX_MAX_CHUNKS 1000000
+
+// Number of masked chunk positions whose permitted cells are kept
+// materialized on each instance, for the attributes read at each of
+// them, 0 to filter masked chunks cell by cell instead
+#define MASKED_CHUNK_CACHE_SIZE 8
+
+// Number of listed chunk positions whose chunks are read ahead of the
+// secure_scan iterators by the background thread of each instance, over
+// all the running scans, 0 to disable read-ahead, and the largest size
+// of the chunks read ahead. The chunks are left in the buffer cache,
+// not held, so this paces the reads rather than bounding memory.
+#define PREFETCH_CHUNKS    8
+#define PREFETCH_MAX_BYTES (64 << 20)
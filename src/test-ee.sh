@@ -5,6 +5,7 @@ NS_SEC=secured
 NS_PER=permissions
 DAT=dataset
 DIM=${DAT}_id
+VER=${DAT}_version
 FLAG=access
 
 
@@ -14,9 +15,13 @@ function cleanup {
     echo "--- entering cleanup"
     ## Cleanup
     iquery -A auth_admin -anq "remove($NS_SEC.$DAT)"      || true
+    iquery -A auth_admin -anq "remove($NS_SEC.${DAT}_ver)" || true
     iquery -A auth_admin -anq "drop_namespace('$NS_SEC')" || true
 
     iquery -A auth_admin -anq "remove($NS_PER.$DIM)"      || true
+    iquery -A auth_admin -anq "remove($NS_PER.$VER)"      || true
+    iquery -A auth_admin -anq "remove($NS_PER.${DIM}_role)" || true
+    iquery -A auth_admin -anq "remove($NS_PER.role_members)" || true
     iquery -A auth_admin -anq "drop_namespace('$NS_PER')" || true
 
     iquery -A auth_admin -anq "drop_user('todd')"         || true
@@ -539,5 +544,284 @@ iquery -A auth_paul -o csv:l -aq "
 diff test.out test.expected
 
 
+echo "29. Use secure_scan with two permission dimensions"
+iquery -A auth_admin -aq "
+    create array $NS_PER.$VER <$FLAG:bool>[user_id;$VER=1:2]"
+iquery -A auth_admin -aq "
+    store(
+      build(<val:string>[$DIM=1:10:0:10;$VER=1:2:0:2],
+            '${DAT}_' + string($DIM) + '_' + string($VER)),
+      $NS_SEC.${DAT}_ver)"
+iquery -A auth_admin -aq "
+    insert(
+        redimension(
+            apply(
+                filter(list('users'), name='todd'),
+                user_id, int64(id),
+                $VER, int64(2),
+                access, true),
+            $NS_PER.$VER),
+        $NS_PER.$VER)"
+
+iquery -A auth_todd -o csv:l -aq "secure_scan($NS_SEC.${DAT}_ver)" > test.out
+cat <<EOF > test.expected
+val
+'${DAT}_1_2'
+'${DAT}_3_2'
+'${DAT}_4_2'
+EOF
+diff test.out test.expected
+
+iquery -A auth_todd -o csv:l -aq "op_count(secure_scan($NS_SEC.$DAT))" \
+    > test.out
+cat <<EOF > test.expected
+count
+3
+EOF
+diff test.out test.expected
+iquery -A auth_admin -aq "remove($NS_PER.$VER); remove($NS_SEC.${DAT}_ver)"
+
+
+echo "30. Use secure_scan twice in one query"
+iquery -A auth_todd -o csv:l -aq "
+    op_count(join(secure_scan($NS_SEC.$DAT), secure_scan($NS_SEC.$DAT)))" \
+    > test.out
+cat <<EOF > test.expected
+count
+3
+EOF
+diff test.out test.expected
+
+
+echo "31. Use secure_scan_stats"
+iquery -A auth_admin -o csv:l -aq "
+    project(
+        apply(
+            aggregate(secure_scan_stats(), sum(queries) as queries),
+            recorded, queries > 0),
+        recorded)" \
+    > test.out
+cat <<EOF > test.expected
+recorded
+true
+EOF
+diff test.out test.expected
+
+iquery -A auth_todd -aq "secure_scan_stats()" 2>&1 \
+    | grep --quiet "Insufficient permissions"
+
+
+echo "32. Use secure_scan in explain mode"
+iquery -A auth_todd -o csv:l -aq "
+    project(
+        filter(secure_scan($NS_SEC.$DAT, true), kind = 'interval'),
+        low, high)" \
+    > test.out
+cat <<EOF > test.expected
+low,high
+1,1
+3,4
+EOF
+diff test.out test.expected
+
+
+echo "33. Use secure_scan_users"
+TODD_ID=$(iquery -A auth_admin -o csv -aq "
+    project(filter(list('users'), name='todd'), id)")
+iquery -A auth_admin -o csv:l -aq "
+    aggregate(secure_scan_users($NS_SEC.$DAT, $TODD_ID), count(*), user_id)" \
+    > test.out
+cat <<EOF > test.expected
+user_id,count
+$TODD_ID,3
+EOF
+diff test.out test.expected
+
+iquery -A auth_todd -aq "secure_scan_users($NS_SEC.$DAT, $TODD_ID)" 2>&1 \
+    | grep --quiet "Insufficient permissions"
+
+iquery -A auth_admin -aq "
+    secure_scan_users($NS_SEC.$DAT, $(seq -s ', ' 0 64))" 2>&1 \
+    | grep --quiet "more than 64 user IDs"
+
+iquery -A auth_admin -aq "secure_scan_users($NS_SEC.$DAT, $TODD_ID, -1)" 2>&1 \
+    | grep --quiet "user IDs must not be null or negative"
+
+
+echo "34. Use secure_scan with a range-encoded permissions array"
+iquery -A auth_admin -aq "
+    create array $NS_PER.$VER <low:int64, high:int64>[user_id; grant_no]"
+iquery -A auth_admin -aq "
+    store(
+      build(<val:string>[$DIM=1:10:0:10;$VER=1:4:0:4],
+            '${DAT}_' + string($DIM) + '_' + string($VER)),
+      $NS_SEC.${DAT}_ver)"
+iquery -A auth_admin -aq "
+    insert(
+        redimension(
+            apply(
+                filter(list('users'), name='todd'),
+                user_id, int64(id),
+                grant_no, int64(0),
+                low, int64(2),
+                high, int64(3)),
+            $NS_PER.$VER),
+        $NS_PER.$VER)"
+
+iquery -A auth_todd -o csv:l -aq "
+    filter(secure_scan($NS_SEC.${DAT}_ver), $DIM = 3)" > test.out
+cat <<EOF > test.expected
+val
+'${DAT}_3_2'
+'${DAT}_3_3'
+EOF
+diff test.out test.expected
+iquery -A auth_admin -aq "remove($NS_PER.$VER); remove($NS_SEC.${DAT}_ver)"
+
+
+echo "35. Use secure_scan with permissions granted to a role"
+iquery -A auth_admin -aq "
+    create array $NS_PER.${DIM}_role <$FLAG:bool>[role_id;$DIM=1:10:0:10]"
+iquery -A auth_admin -aq "
+    create array $NS_PER.role_members <member:bool>[user_id;role_id]"
+iquery -A auth_admin -aq "
+    store(build(<$FLAG:bool>[role_id=7:7;$DIM=2:2], true), $NS_PER.${DIM}_role)"
+iquery -A auth_admin -aq "
+    insert(
+        redimension(
+            apply(
+                filter(list('users'), name='todd'),
+                user_id, int64(id),
+                role_id, int64(7),
+                member, true),
+            $NS_PER.role_members),
+        $NS_PER.role_members)"
+
+iquery -A auth_todd -o csv:l -aq "secure_scan($NS_SEC.$DAT)" > test.out
+cat <<EOF > test.expected
+val
+'${DAT}_1'
+'${DAT}_2'
+'${DAT}_3'
+'${DAT}_4'
+EOF
+diff test.out test.expected
+iquery -A auth_admin -aq "remove($NS_PER.${DIM}_role); remove($NS_PER.role_members)"
+
+
+echo "36. Use secure_scan with attributes and bounds"
+iquery -A auth_todd -o csv:l -aq "secure_scan($NS_SEC.$DAT, 'val', 3, 10)" \
+    > test.out
+cat <<EOF > test.expected
+val
+'${DAT}_3'
+'${DAT}_4'
+EOF
+diff test.out test.expected
+
+iquery -A auth_todd -o csv+:l -aq "secure_scan($NS_SEC.$DAT, 3, 4)" \
+    > test.out
+cat <<EOF > test.expected
+$DIM,val
+3,'${DAT}_3'
+4,'${DAT}_4'
+EOF
+diff test.out test.expected
+
+iquery -A auth_todd -aq "secure_scan($NS_SEC.$DAT, null, 3)" 2>&1 \
+    | grep --quiet "optional parameters must not be null"
+
+iquery -A auth_admin -o csv:l -aq "secure_scan($NS_SEC.$DAT, 2, 3)" \
+    > test.out
+cat <<EOF > test.expected
+val
+'${DAT}_2'
+'${DAT}_3'
+EOF
+diff test.out test.expected
+
+iquery -A auth_todd -aq "secure_scan($NS_SEC.$DAT, 'val_WRONG')" 2>&1 \
+    | grep --quiet "scanned array does not have attribute val_WRONG"
+
+
+
+echo "37. Use secure_scan with a very wide range grant"
+iquery -A auth_admin -aq "
+    create array $NS_PER.$VER <low:int64, high:int64>[user_id; grant_no]"
+iquery -A auth_admin -aq "
+    create array $NS_SEC.${DAT}_ver <val:string>[$DIM=1:10:0:10;$VER=0:*:0:1]"
+iquery -A auth_admin -aq "
+    store(
+      redimension(
+        build(<val:string>[$DIM=1:10:0:10;$VER=1:4:0:4],
+              '${DAT}_' + string($DIM) + '_' + string($VER)),
+        $NS_SEC.${DAT}_ver),
+      $NS_SEC.${DAT}_ver)"
+iquery -A auth_admin -aq "
+    insert(
+        redimension(
+            apply(
+                filter(list('users'), name='todd'),
+                user_id, int64(id),
+                grant_no, int64(0),
+                low, int64(0),
+                high, int64(1000000000000)),
+            $NS_PER.$VER),
+        $NS_PER.$VER)"
+
+iquery -A auth_todd -o csv:l -aq "
+    filter(secure_scan($NS_SEC.${DAT}_ver), $DIM = 3)" > test.out
+cat <<EOF > test.expected
+val
+'${DAT}_3_1'
+'${DAT}_3_2'
+'${DAT}_3_3'
+'${DAT}_3_4'
+EOF
+diff test.out test.expected
+iquery -A auth_admin -aq "remove($NS_PER.$VER); remove($NS_SEC.${DAT}_ver)"
+
+
+echo "38. Use secure_scan with many fragmented grants"
+iquery -A auth_admin -aq "
+    create array $NS_PER.$VER <$FLAG:bool>[user_id;$VER=0:*]"
+iquery -A auth_admin -aq "
+    store(
+      build(<val:string>[$DIM=1:10:0:10;$VER=0:4095:0:1024],
+            '${DAT}_' + string($DIM) + '_' + string($VER)),
+      $NS_SEC.${DAT}_ver)"
+iquery -A auth_admin -aq "
+    insert(
+        redimension(
+            apply(
+                cross_join(
+                    filter(list('users'), name='todd'),
+                    build(<$VER:int64>[grant_no=0:2047], 2 * grant_no)),
+                user_id, int64(id),
+                access, true),
+            $NS_PER.$VER),
+        $NS_PER.$VER)"
+
+iquery -A auth_todd -o csv:l -aq "secure_scan($NS_SEC.${DAT}_ver)" \
+    | sort > test.out
+iquery -A auth_admin -o csv:l -aq "
+    project(
+        filter(
+            scan($NS_SEC.${DAT}_ver),
+            ($DIM = 1 or $DIM = 3 or $DIM = 4) and $VER % 2 = 0),
+        val)" \
+    | sort > test.expected
+diff test.out test.expected
+
+iquery -A auth_todd -o csv:l -aq "op_count(secure_scan($NS_SEC.${DAT}_ver))" \
+    > test.out
+cat <<EOF > test.expected
+count
+6144
+EOF
+diff test.out test.expected
+iquery -A auth_admin -aq "remove($NS_PER.$VER); remove($NS_SEC.${DAT}_ver)"
+
+
 echo "### PASSED ALL TESTS"
 exit 0